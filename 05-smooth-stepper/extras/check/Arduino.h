@@ -0,0 +1,55 @@
+/*
+ * Arduino.h
+ *
+ * Minimal host-side replacement of the Arduino core for running the stepper code
+ * natively. Time is provided by a virtual clock that is set by the checks.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef max
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#define constrain(x, a, b) ((x) < (a) ? (a) : ((x) > (b) ? (b) : (x)))
+
+// virtual_micros is the current time of the virtual clock in micros.
+extern unsigned long virtual_micros;
+
+inline unsigned long micros() { return virtual_micros; }
+inline unsigned long millis() { return virtual_micros / 1000; }
+inline void delayMicroseconds(unsigned int us) { virtual_micros += us; }
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+
+#define VIRTUAL_PINS 32
+
+// virtual_pins holds the values of the virtual digital and PWM pins.
+extern int virtual_pins[VIRTUAL_PINS];
+
+inline void pinMode(uint8_t pin, uint8_t mode) {}
+inline int digitalRead(uint8_t pin) { return virtual_pins[pin]; }
+inline void digitalWrite(uint8_t pin, uint8_t value) { virtual_pins[pin] = value; }
+inline void analogWrite(uint8_t pin, int value) { virtual_pins[pin] = value; }
+
+// HostSerial prints to stdout, so that debug output of the stepper remains visible.
+class HostSerial {
+public:
+    void print(const char *text) { fputs(text, stdout); }
+    void print(long value)       { printf("%ld", value); }
+    void println(const char *text) { print(text); println(); }
+    void println(long value)       { print(value); println(); }
+    void println()                 { fputc('\n', stdout); }
+};
+
+extern HostSerial Serial;
+
+#endif // Arduino_h
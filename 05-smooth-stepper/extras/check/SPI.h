@@ -0,0 +1,35 @@
+/*
+ * SPI.h
+ *
+ * Host-side replacement of the SPI library that records the bytes of the last transfer.
+ */
+
+#ifndef SPI_h
+#define SPI_h
+
+#include <stdint.h>
+
+#define MSBFIRST  1
+#define SPI_MODE0 0
+
+struct SPISettings {
+    SPISettings(unsigned long clock, uint8_t order, uint8_t mode) {}
+};
+
+#define HOST_SPI_MAX 16
+
+// HostSPI keeps the bytes sent since the last beginTransaction.
+class HostSPI {
+public:
+    uint8_t sent[HOST_SPI_MAX];
+    int num_sent = 0;
+    int transfers = 0;
+    void begin() {}
+    void beginTransaction(SPISettings settings) { num_sent = 0; transfers++; }
+    uint8_t transfer(uint8_t b) { if (num_sent < HOST_SPI_MAX) sent[num_sent++] = b; return 0; }
+    void endTransaction() {}
+};
+
+extern HostSPI SPI;
+
+#endif // SPI_h
@@ -0,0 +1,274 @@
+/*
+ * check.cpp
+ *
+ * Host-native checks of the smooth-stepper code that is not used by the default
+ * build of the sketch. Runs the code against a virtual clock and virtual pins.
+ */
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "astep.h"
+#include "agroup.h"
+#include "ashift.h"
+#include "deferlog.h"
+
+unsigned long virtual_micros = 1;
+int virtual_pins[VIRTUAL_PINS];
+HostSerial Serial;
+HostSPI SPI;
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+// checkGroup moves two axes together and checks that the shorter axis stays on the
+// line of the move (Bresenham error below one step) and both axes arrive together.
+static void checkGroup() {
+    SmoothStepper x(2048, 2, 3, 4, 5);
+    SmoothStepper y(2048, 6, 7, 8, 9);
+    StepperGroup group;
+    CHECK(group.add(&x) == 0);
+    CHECK(group.add(&y) == 1);
+    group.setRPM(10);
+
+    long targets[] = {300, -120};
+    group.moveTo(targets);
+    CHECK(group.remaining() == 300);
+    long ticks = 0;
+    while (!group.done() && ticks < 1000) {
+        virtual_micros += 100;
+        if (!group.step()) continue;
+        ticks++;
+        long ideal = -120 * ticks / 300;  // position on the line of the move
+        CHECK(labs(y.getPosition() - ideal) <= 1);
+    }
+    CHECK(ticks == 300);
+    CHECK(x.getPosition() == 300);
+    CHECK(y.getPosition() == -120);
+
+    long steps[] = {-50, 50};
+    group.move(steps);
+    while (!group.done()) { virtual_micros += 100; group.step(); }
+    CHECK(x.getPosition() == 250);
+    CHECK(y.getPosition() == -70);
+}
+
+// checkQueue runs two queued moves and checks that the stepper returns to free stepping.
+static void checkQueue() {
+    SmoothStepper m(2048, 2, 3, 4, 5);
+    m.setRPM(10);
+    CHECK(m.queueMove(20, DIR_CW));
+    CHECK(m.queueMove(5, DIR_CCW));
+    long steps = 0;
+    while (!m.queueDone() && steps < 1000) {
+        virtual_micros += 100;
+        steps += m.step();
+    }
+    CHECK(steps == 25);
+    CHECK(m.getPosition() == 15);
+
+    m.setDir(DIR_CW);
+    virtual_micros += 10000;
+    CHECK(m.step() == 1);                // free stepping after the queue
+    CHECK(m.getPosition() == 16);
+    CHECK(m.distanceToGo() == 0);
+}
+
+// checkGovernor runs the stepper from a loop that is too slow even for the min RPM
+// and checks that the governor caps the RPM to the min RPM, then restores it.
+static void checkGovernor() {
+    SmoothStepper m(2048, 2, 3, 4, 5);
+    m.setRPM(15);
+    m.setGovernor(true);
+    for (int i = 0; i < 2 * GOVERNOR_WINDOW; i++) {
+        virtual_micros += 29000;         // just below the step delay at 1 RPM (29297)
+        m.step();
+    }
+    CHECK(m.getGovernorRPM() == 1);
+    CHECK(m.getRPM() == 1);
+    CHECK(m.getThrottling());
+    for (int i = 0; i < 3 * GOVERNOR_WINDOW; i++) {
+        virtual_micros += 500;
+        m.step();
+    }
+    CHECK(m.getRPM() == 15);
+    CHECK(!m.getThrottling());
+}
+
+// checkPower steps at 1 RPM (29 ms per step) with a 20 ms hold time and checks that the
+// current is only reduced after 2 step delays and released after the release time.
+static void checkPower() {
+    SmoothStepper m(2048, 2, 3, 4, 5);
+    m.setRPM(1);
+    m.setPower(20000L, 64, 150000L);
+    virtual_micros += 30000;
+    CHECK(m.step() == 1);
+    virtual_micros += 25000;
+    m.updatePower();
+    CHECK(m.getPowerState() == POWER_ON);  // between two steps
+    virtual_micros += 35000;
+    m.updatePower();
+    CHECK(m.getPowerState() == POWER_HOLD);
+    virtual_micros += 100000;
+    m.updatePower();
+    CHECK(m.getPowerState() == POWER_OFF);
+    virtual_micros += 30000;
+    CHECK(m.step() == 1);
+    CHECK(m.getPowerState() == POWER_ON);
+}
+
+// checkShift drives a stepper via the upper nibble of a shift register and checks that
+// steps, the software PWM of the holding current, and stop() reach the register.
+static void checkShift() {
+    ShiftOutput output(10, 1);
+    output.setup();
+    SmoothStepper m(2048, &output, 1);
+    m.setRPM(10);
+    m.setPower(20000L, 128, 150000L);
+
+    virtual_micros += 10000;
+    CHECK(m.step() == 1);
+    CHECK(SPI.num_sent == 1);
+    CHECK(SPI.sent[0] != 0 && (SPI.sent[0] & 0x0F) == 0);  // coils of slot 1 in Q4-Q7
+    uint8_t coils = SPI.sent[0];
+
+    virtual_micros += 30000;
+    virtual_micros &= ~(HOLD_PWM_PERIOD - 1);  // start of a PWM period: coils on
+    virtual_micros += HOLD_PWM_PERIOD * 3 / 4;  // past the duty cycle: coils off
+    m.updatePower();
+    CHECK(m.getPowerState() == POWER_HOLD);
+    CHECK(SPI.sent[0] == 0);
+    virtual_micros += HOLD_PWM_PERIOD / 2;      // next period: coils on
+    m.updatePower();
+    CHECK(SPI.sent[0] == coils);
+
+    int transfers = SPI.transfers;
+    m.stop();
+    CHECK(SPI.transfers == transfers + 1);
+    CHECK(SPI.sent[0] == 0);
+}
+
+// checkHistogram steps at a steady rate with a pause of the caller (e.g., a released key)
+// and a stall of the loop in between: the pause is not recorded as step interval error,
+// the stall is.
+static void checkHistogram() {
+    SmoothStepper m(2048, 2, 3, 4, 5);
+    m.setRPM(10);                        // 2929 micros per step
+    for (int i = 0; i < 10; i++) {
+        virtual_micros += 3000;
+        m.step();
+    }
+    m.pause();
+    virtual_micros += 500000;            // pause
+    for (int i = 0; i < 10; i++) {
+        virtual_micros += 3000;
+        m.step();
+    }
+    Histogram h = m.getStepHistogram();
+    CHECK(h.samples() == 18);            // first step and the step after the pause are skipped
+    CHECK(h.maxValue() < 100);
+
+    virtual_micros += 50000;             // stall
+    m.step();
+    h = m.getStepHistogram();
+    CHECK(h.samples() == 19);
+    CHECK(h.maxValue() > 40000);
+}
+
+// checkDeferLog overflows the log and drains it like the sketch: the number of dropped
+// records must be reported once the first pop made room for it.
+static void checkDeferLog() {
+    DeferredLog log;
+    for (int i = 0; i < DEFERLOG_SIZE + 5; i++) log.add(1, i);
+    CHECK(log.size() == DEFERLOG_SIZE);
+    CHECK(log.dropped() == 5);
+    CHECK(!log.addDropped(0));           // still full, keep counting
+    CHECK(log.dropped() == 5);
+
+    LogRecord r;
+    int records = 0;
+    int reported = -1;
+    while (log.pop(r)) {
+        log.addDropped(0);
+        if (r.id == 0) reported = r.a;
+        else           CHECK(r.a == records);
+        records++;
+    }
+    CHECK(records == DEFERLOG_SIZE + 1);
+    CHECK(reported == 5);
+    CHECK(log.dropped() == 0);
+}
+
+// checkProfile runs trapezoid and S-curve moves at 25 RPM, above the default max RPM
+// of 15, and checks that they reach the cruise speed and stop at the start/stop speed.
+static void checkProfile() {
+    int profiles[] = {PROFILE_TRAPEZOID, PROFILE_SCURVE};
+    for (int i = 0; i < 2; i++) {
+        SmoothStepper m(2048, 2, 3, 4, 5);
+        m.setRPMRange(1, 30);
+        m.setRPM(25);
+        CHECK(m.getRPM() == 25);
+        m.setProfile(profiles[i]);
+        m.setAcceleration(1000);
+        m.setJerk(8000);
+        m.move(3000);
+        long max_speed = 0;
+        long arrival_speed = 0;
+        long calls = 0;
+        while (m.distanceToGo() != 0 && calls < 10000000L) {
+            virtual_micros += 100;
+            calls++;
+            if (!m.step()) continue;
+            max_speed = max(max_speed, m.getSpeed());
+            arrival_speed = m.getSpeed();
+        }
+        CHECK(m.getPosition() == 3000);
+        CHECK(max_speed > 512);          // above 15 RPM (512 steps/s)
+        CHECK(max_speed <= 854);         // 25 RPM
+        CHECK(arrival_speed < 80);       // start/stop speed is 34 steps/s
+    }
+}
+
+// checkClock steps with a single key press followed by its first repeat ~108 ms later
+// and checks that the pause is not observed as lateness or missed deadline.
+static void checkClock() {
+    int policies[] = {CLOCK_FREE, CLOCK_BURST, CLOCK_SKIP, CLOCK_CLAMP};
+    for (int i = 0; i < 4; i++) {
+        SmoothStepper m(2048, 2, 3, 4, 5);
+        m.setRPM(10);                    // 2929 micros per step
+        m.setClockPolicy(policies[i]);
+        for (int n = 0; n < 3; n++) {
+            virtual_micros += 108000;    // pause until the next repeat
+            for (int k = 0; k < 300; k++) {  // 30 ms of loops every 100 micros
+                virtual_micros += 100;
+                m.step();
+            }
+        }
+        CHECK(m.getLateMax() < 200);
+        CHECK(m.getMissedDeadlines() == 0);
+    }
+}
+
+// run runs a check and prints its result.
+static void run(const char *name, void (*check)()) {
+    int before = failures;
+    check();
+    printf("%s: %s\n", name, failures == before? "ok" : "FAIL");
+}
+
+int main() {
+    run("group", checkGroup);
+    run("queue", checkQueue);
+    run("governor", checkGovernor);
+    run("power", checkPower);
+    run("profile", checkProfile);
+    run("clock", checkClock);
+    run("shift", checkShift);
+    run("histogram", checkHistogram);
+    run("deferlog", checkDeferLog);
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
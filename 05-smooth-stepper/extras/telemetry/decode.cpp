@@ -0,0 +1,161 @@
+// decode.cpp decodes the binary telemetry frames of the smooth-stepper sketch
+// (see src/telemetry.h) and prints them with the same fields as the text status lines.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "telemetry.h"
+#include "funduino_ir.h"
+
+static unsigned long frames = 0;
+static unsigned long bad_frames = 0;
+static unsigned long lost_frames = 0;
+
+static const char* stateName(unsigned long state) {
+    switch (state) {
+    case 0:  return "SIGSTATE_IDLE";
+    case 1:  return "SIGSTATE_ACTIVE";
+    case 2:  return "SIGSTATE_ACTIVE_WAITING";
+    case 3:  return "SIGSTATE_ACTIVE_REPEATING";
+    default: return "UNKNOWN";
+    }
+}
+
+static const char* dirName(unsigned long dir) {
+    switch (dir) {
+    case 0:  return "DIR_UNSPECIFIED";
+    case 1:  return "DIR_CW";
+    case 2:  return "DIR_CCW";
+    default: return "UNKNOWN";
+    }
+}
+
+static const char* powerName(unsigned long power) {
+    switch (power) {
+    case 0:  return "POWER_ON";
+    case 1:  return "POWER_HOLD";
+    case 2:  return "POWER_OFF";
+    default: return "UNKNOWN";
+    }
+}
+
+static const char* sequenceName(unsigned long sequence) {
+    switch (sequence) {
+    case 0:  return "SEQUENCE_FULL";
+    case 1:  return "SEQUENCE_HALF";
+    case 2:  return "SEQUENCE_WAVE";
+    default: return "UNKNOWN";
+    }
+}
+
+static long zigzag(unsigned long v) { return (long)(v >> 1) ^ -(long)(v & 1); }
+
+// decodeFields decodes all varint fields of a payload and returns the number of fields.
+static int decodeFields(const uint8_t *p, int n, unsigned long *fields, int max_fields) {
+    int count = 0;
+    int i = 0;
+    while (i < n && count < max_fields) {
+        unsigned long v = 0;
+        int shift = 0;
+        while (i < n) {
+            uint8_t b = p[i++];
+            v |= (unsigned long)(b & 0x7F) << shift;
+            shift += 7;
+            if (!(b & 0x80)) break;
+        }
+        fields[count++] = v;
+    }
+    return count;
+}
+
+static void printStatus(uint8_t seq, const unsigned long *f) {
+    printf("#%03u msg: %s", seq, telemetryMessage(f[TM_MSG]));
+    printf(", cmd: %s", funduino_command(f[TM_CMD]));
+    printf(", state: %s", stateName(f[TM_STATE]));
+    printf(", rec_gap: %lu", f[TM_REC_GAP]);
+    printf(", steps: %ld", zigzag(f[TM_STEPS]));
+    printf(", max_steps: %ld", zigzag(f[TM_MAX_STEPS]));
+    printf(", call_gap: %lu", f[TM_CALL_GAP]);
+    printf(", step_gap: %lu", f[TM_STEP_GAP]);
+    printf(", late_avg: %lu", f[TM_LATE_AVG]);
+    printf(", late_max: %lu", f[TM_LATE_MAX]);
+    printf(", err_p50: %lu", f[TM_ERR_P50]);
+    printf(", err_p99: %lu", f[TM_ERR_P99]);
+    printf(", max_lt: %lu", f[TM_MAX_LT]);
+    printf(", avg_lt: %lu", f[TM_AVG_LT]);
+    printf(", p50_lt: %lu", f[TM_P50_LT]);
+    printf(", p99_lt: %lu", f[TM_P99_LT]);
+    printf(", rpm: %lu%s", f[TM_RPM], f[TM_THROTTLED]? " (throttled)" : "");
+    printf(", dir: %s", dirName(f[TM_DIR]));
+    printf(", phase: %lu", f[TM_PHASE]);
+    printf(", power: %s", powerName(f[TM_POWER]));
+    printf(", seq: %s", sequenceName(f[TM_SEQUENCE]));
+    printf(", queue: %lu", f[TM_QUEUE]);
+    printf("\n");
+}
+
+// decodeFrame checks and prints one frame; returns false if the checksum does not match.
+static bool decodeFrame(const uint8_t *frame, int len) {
+    uint8_t ck_a = 0, ck_b = 0;
+    for (int i = 1; i < len + 2; i++) {
+        ck_a += frame[i];
+        ck_b += ck_a;
+    }
+    if (ck_a != frame[len + 2] || ck_b != frame[len + 3]) return false;
+
+    static int last_seq = -1;
+    uint8_t type = frame[2];
+    uint8_t seq = frame[3];
+    if (last_seq >= 0) lost_frames += (uint8_t)(seq - last_seq - 1);
+    last_seq = seq;
+    frames++;
+
+    unsigned long fields[TM_FIELDS] = {0};
+    int n = decodeFields(frame + 4, len - 2, fields, TM_FIELDS);
+    if (type == TELEMETRY_STATUS && n == TM_FIELDS) {
+        printStatus(seq, fields);
+    } else if (type == TELEMETRY_LOG && n == TM_LOG_FIELDS) {
+        printf("#%03u log: %lu, time: %lu, a: %ld, b: %ld\n", seq, fields[TM_LOG_ID],
+               fields[TM_LOG_TIME], zigzag(fields[TM_LOG_A]), zigzag(fields[TM_LOG_B]));
+    } else {
+        printf("#%03u type: %u, fields: %d\n", seq, type, n);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    FILE *in = stdin;
+    if (argc > 1 && (in = fopen(argv[1], "rb")) == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    // scan for SYNC and decode the frame; after a bad frame, rescan from the byte after SYNC
+    uint8_t buf[TELEMETRY_MAX_PAYLOAD + 4];
+    int n = 0;
+    bool eof = false;
+    while (!eof || n > 0) {
+        while (!eof && n < (int)sizeof(buf)) {
+            int c = fgetc(in);
+            if (c == EOF) eof = true;
+            else          buf[n++] = c;
+            if (n >= 2 && n >= buf[1] + 4) break;  // frame complete
+        }
+        if (n == 0) break;
+        int drop = 1;
+        if (buf[0] == TELEMETRY_SYNC && n >= 2) {
+            int len = buf[1];
+            if (len < 2 || len > TELEMETRY_MAX_PAYLOAD) bad_frames++;
+            else if (n < len + 4)                       { if (eof) break; else continue; }
+            else if (decodeFrame(buf, len))             drop = len + 4;
+            else                                        bad_frames++;
+        } else if (buf[0] == TELEMETRY_SYNC && !eof) {
+            continue;                                   // wait for LEN
+        }
+        n -= drop;
+        for (int i = 0; i < n; i++) buf[i] = buf[i + drop];
+        fflush(stdout);
+    }
+    fprintf(stderr, "frames: %lu, bad: %lu, lost: %lu\n", frames, bad_frames, lost_frames);
+    return 0;
+}
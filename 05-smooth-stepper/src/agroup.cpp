@@ -0,0 +1,76 @@
+#include "Arduino.h"
+#include "astep.h"
+#include "agroup.h"
+#include "ashift.h"
+
+#define MINUTE 60L * 1000L * 1000L
+
+// add adds a stepper as the next axis and returns its axis index or -1 if the group is full.
+// The steppers must use polled stepping (no timer or profile), the group steps them directly.
+int StepperGroup::add(SmoothStepper *stepper) {
+    if (stepper == NULL || num_axes >= GROUP_MAX_AXES) return -1;
+    axes[num_axes] = stepper;
+    delta[num_axes] = 0;
+    error[num_axes] = 0;
+    num_axes++;
+    if (num_axes == 1) setRPM(stepper->getRPM());
+    return num_axes - 1;
+}
+
+// setRPM sets the speed of the longest axis in rotations per minute of the first stepper.
+void StepperGroup::setRPM(int rpm) {
+    if (num_axes == 0) return;
+    step_delay_micros = MINUTE / axes[0]->getStepsPerRev() / max(1, rpm);
+}
+
+// moveTo moves all axes to the given absolute positions, one target per axis.
+void StepperGroup::moveTo(const long targets[]) {
+    plan(targets);
+}
+
+// move moves all axes by the given number of steps, one value per axis.
+void StepperGroup::move(const long steps[]) {
+    long targets[GROUP_MAX_AXES];
+    for (uint8_t i = 0; i < num_axes; i++) targets[i] = axes[i]->getPosition() + steps[i];
+    plan(targets);
+}
+
+// plan sets the direction, distance, and Bresenham error of each axis.
+void StepperGroup::plan(const long targets[]) {
+    major_steps = 0;
+    for (uint8_t i = 0; i < num_axes; i++) {
+        long d = targets[i] - axes[i]->getPosition();
+        axes[i]->setDir(d < 0? DIR_CCW : DIR_CW);
+        delta[i] = labs(d);
+        if (delta[i] > major_steps) major_steps = delta[i];
+    }
+    for (uint8_t i = 0; i < num_axes; i++) error[i] = major_steps / 2;  // round to the nearest tick
+    ticks = major_steps;
+}
+
+// step runs one tick of the group if the step delay has passed and returns 1,
+// otherwise it returns 0. On each tick, the longest axis steps once and each other axis
+// steps if its accumulated share of the move reaches one step.
+int StepperGroup::step() {
+    if (ticks == 0) return 0;
+    unsigned long now = micros();
+    if (now - step_time_micros < step_delay_micros) return 0;
+    step_time_micros = now;
+    for (uint8_t i = 0; i < num_axes; i++) {
+        error[i] += delta[i];
+        if (error[i] >= major_steps) {
+            error[i] -= major_steps;
+            axes[i]->stepNow(now);
+        }
+    }
+    if (output != NULL) output->update();  // latch all axes at once
+    ticks--;
+    return 1;
+}
+
+// stop cancels the current move and turns off all steppers.
+void StepperGroup::stop() {
+    ticks = 0;
+    for (uint8_t i = 0; i < num_axes; i++) axes[i]->stop();
+    if (output != NULL) output->update();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Arduino.h"
+
+#define GROUP_MAX_AXES 4  // max steppers per group
+
+class SmoothStepper;
+class ShiftOutput;
+
+// StepperGroup moves several steppers from a single time base.
+// All axes start and stop together: the axis with the longest distance steps on
+// every tick and the other axes are interpolated via integer Bresenham errors.
+class StepperGroup {
+private:
+    SmoothStepper *axes[GROUP_MAX_AXES];
+    ShiftOutput *output = NULL;           // shared output, updated once per tick
+    uint8_t num_axes = 0;
+    long delta[GROUP_MAX_AXES];           // absolute steps to go per axis
+    long error[GROUP_MAX_AXES];           // Bresenham error per axis
+    long major_steps = 0;                 // steps of the longest axis (= ticks of the move)
+    long ticks = 0;                       // remaining ticks of the move
+    unsigned long step_delay_micros = 0;
+    unsigned long step_time_micros = 0;
+    void plan(const long targets[]);
+public:
+    inline StepperGroup() {}
+    ~StepperGroup() {}
+    int  add(SmoothStepper *stepper);
+    void setRPM(int rpm);
+    void setOutput(ShiftOutput *output) { this->output = output; }
+    void moveTo(const long targets[]);
+    void move(const long steps[]);
+    int  step();
+    void stop();
+
+    uint8_t size()      { return num_axes; }
+    bool    done()      { return ticks == 0; }
+    long    remaining() { return ticks; }  // remaining ticks of the longest axis
+};
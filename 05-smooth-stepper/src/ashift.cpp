@@ -0,0 +1,62 @@
+#include "Arduino.h"
+#include "SPI.h"
+#include "astep.h"
+#include "ashift.h"
+
+// setup configures SPI and the latch pin and clears all outputs.
+void ShiftOutput::setup() {
+    pinMode(latch_pin, OUTPUT);
+    digitalWrite(latch_pin, LOW);
+#if defined(__AVR__)
+    latch_port = portOutputRegister(digitalPinToPort(latch_pin));
+    latch_mask = digitalPinToBitMask(latch_pin);
+#endif
+    SPI.begin();
+    write();
+}
+
+// setNibble sets the four output bits of the given stepper slot.
+// Even slots use Q0-Q3 and odd slots use Q4-Q7 of register slot/2.
+void ShiftOutput::setNibble(uint8_t slot, uint8_t bits) {
+    uint8_t i = slot >> 1;
+    if (i >= num_registers) return;
+    uint8_t shift = (slot & 1) << 2;
+    STEPPER_ATOMIC {
+        uint8_t value = (frame[i] & ~(0x0F << shift)) | ((bits & 0x0F) << shift);
+        if (value != frame[i]) {
+            frame[i] = value;
+            dirty = true;
+        }
+    }
+}
+
+// update transfers the frame if any stepper changed its outputs.
+// Call it once per scheduler tick, after all steppers have stepped.
+void ShiftOutput::update() {
+    if (dirty) write();
+}
+
+// write transfers the frame and latches all outputs at once.
+// The last register of the chain is shifted first.
+void ShiftOutput::write() {
+    STEPPER_ATOMIC {
+        SPI.beginTransaction(SPISettings(SHIFT_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+        for (uint8_t i = num_registers; i > 0; i--) SPI.transfer(frame[i - 1]);
+        SPI.endTransaction();
+        latch();
+        dirty = false;
+    }
+}
+
+// latch pulses the latch pin to copy the shifted frame to the outputs.
+void ShiftOutput::latch() {
+#if defined(__AVR__)
+    if (latch_port != NULL) {
+        *latch_port |= latch_mask;
+        *latch_port &= ~latch_mask;
+        return;
+    }
+#endif
+    digitalWrite(latch_pin, HIGH);
+    digitalWrite(latch_pin, LOW);
+}
@@ -0,0 +1,33 @@
+#define SHIFT_MAX_REGISTERS 8           // max daisy-chained 74HC595 (2 steppers each)
+#define SHIFT_SPI_CLOCK     8000000L    // SPI clock of the transfer (74HC595 supports > 20 MHz)
+
+// ShiftOutput drives the coils of many steppers via daisy-chained 74HC595 shift registers
+// connected to the hardware SPI (MOSI to SER, SCK to SRCLK) and a latch pin (RCLK).
+// Each stepper uses one nibble (Q0-Q3 or Q4-Q7) of the frame. Steppers only update the
+// frame; update() transfers the frame and latches all outputs at once.
+class ShiftOutput {
+private:
+    int latch_pin;
+    uint8_t num_registers;
+    uint8_t frame[SHIFT_MAX_REGISTERS];  // frame[0] is the register closest to the MCU
+    volatile bool dirty = true;
+#if defined(__AVR__)
+    volatile uint8_t *latch_port = NULL;
+    uint8_t latch_mask = 0;
+#endif
+    void latch();
+public:
+    inline ShiftOutput(int latch_pin, uint8_t num_registers) {
+        this->latch_pin = latch_pin;
+        this->num_registers = constrain(num_registers, 1, SHIFT_MAX_REGISTERS);
+        for (uint8_t i = 0; i < SHIFT_MAX_REGISTERS; i++) frame[i] = 0;
+    }
+    ~ShiftOutput() {}
+    void setup();
+    void setNibble(uint8_t slot, uint8_t bits);
+    void update();
+    void write();
+
+    uint8_t slots()   { return num_registers * 2; }
+    bool    pending() { return dirty; }
+};
@@ -1,14 +1,27 @@
 # include "Arduino.h"
 # include "astep.h"
+# include "ashift.h"
 
 #define MINUTE 60L * 1000L * 1000L
 
+#ifdef STEPPER_TIMER_ENABLED
+// timer_stepper is the stepper driven by the Timer1 interrupt.
+static SmoothStepper *timer_stepper = NULL;
+
+ISR(TIMER1_COMPA_vect) {
+    if (timer_stepper != NULL) timer_stepper->timerStep();
+}
+#endif
+
 // setup configures the stepper's pins, inital direction and RPM.
 void SmoothStepper::setup() {
-    pinMode(pin_1, OUTPUT);
-    pinMode(pin_2, OUTPUT);
-    pinMode(pin_3, OUTPUT);
-    pinMode(pin_4, OUTPUT);
+    if (shift_output == NULL) {
+        pinMode(pin_1, OUTPUT);
+        pinMode(pin_2, OUTPUT);
+        pinMode(pin_3, OUTPUT);
+        pinMode(pin_4, OUTPUT);
+        setupPhasePort();          // resolve pins for single-write phase output
+    }
     setRPMRange(min_rmp, max_rmp); // ensure we have a valid RPM and RPM Range
     setDir(direction);             // ensure we have a valid direction
 }
@@ -21,46 +34,234 @@ void SmoothStepper::setDir(int dir) {
     }
 }
 
+// setSequence selects the phase sequence: SEQUENCE_FULL, SEQUENCE_HALF, or SEQUENCE_WAVE.
+// SEQUENCE_HALF doubles the steps per rotation; the step delay is adjusted to keep the RPM.
+// Positions and step counts are always given in steps of the current sequence.
+void SmoothStepper::setSequence(int sequence) {
+    if (sequence != SEQUENCE_HALF && sequence != SEQUENCE_WAVE) sequence = SEQUENCE_FULL;
+    this->sequence = sequence;
+    if      (sequence == SEQUENCE_FULL) phase &= ~1;  // align to the two-coil phases
+    else if (sequence == SEQUENCE_WAVE) phase |= 1;   // align to the one-coil phases
+    setRPM(requested_rpm);
+}
+
 // setRPM sets the rotations per minute of the stepper.
 // This requires the stepper to have a correct maximum number of steps configured
 // via the contructor.
+// If the governor is enabled, the RPM is capped to what the loop can sustain and restored
+// once the loop is fast enough again.
 void SmoothStepper::setRPM(int rpm) {
     if      (rpm < min_rmp) rpm = min_rmp; // cap to min RPM
     else if (rpm > max_rmp) rpm = max_rmp; // cap to max RPM
-    step_delay_micros = MINUTE / motor_steps / max(1, rpm);
+    requested_rpm = rpm;
+    if (governor && governor_rpm > 0 && rpm > governor_rpm) {
+        rpm = governor_rpm;                // cap to the sustainable RPM
+    }
+    unsigned long rev_steps = getStepsPerRev();
+    step_delay_micros = MINUTE / rev_steps / max(1, rpm);
     this->rpm = rpm;
+    // profile speeds in steps/s as Q16.16, the division only happens when changing the RPM
+    max_speed_q16 = ((unsigned long)rpm * rev_steps << 10) / 60 << 6;
+    min_speed_q16 = ((unsigned long)min_rmp * rev_steps << 10) / 60 << 6;
+    if (timer_mode) setTimerDelay();
 }
 
 // setRPMRange sets and limits the steppers RPM range.
 // Independent of the given values, the min_rpm cannot be below 1 and the
 // max_rpm cannot be below the min_rpm.
 void SmoothStepper::setRPMRange(int min_rpm, int max_rpm) {
-    this->min_rmp = max(1, min_rmp);
-    this->max_rmp = max(this->min_rmp, max_rmp);
-    setRPM(rpm);  // reset RPM in case range changed
+    this->min_rmp = max(1, min_rpm);
+    this->max_rmp = max(this->min_rmp, max_rpm);
+    setRPM(requested_rpm);  // reset RPM in case range changed
 }
 
 // step will either signal the stepper to move ONE step and return 1 or
 // reject to signal the stepper if the previous phase is still active and return 0.
 // The return value can be used to count the absolute number of steps stepped.
+// While queued moves are pending, step() moves towards their target instead.
 int SmoothStepper::step() {
+    drainQueue();                                        // start the next queued move if due
+    if (timer_mode) return 0;                            // the timer interrupt is stepping
     unsigned long now = micros();
     step_call_gap_micros = now - step_call_time_micros;  // allow tracking how often step is called
     step_call_time_micros = now;
-    if (now - step_time_micros < step_delay_micros) {    // don't step if previous phase is not finished
+    if (governor) observeCallGap(step_call_gap_micros);
+    if (profile != PROFILE_NONE) return profileStep(now);
+    if (queue_active && target_position == position) {  // wait for the next queued move
+        return 0;
+    }
+    if (!clockStep(now)) {                               // don't step if previous phase is not finished
         return 0;                                        // and return 0 to indicate a skipped step
     }
     step_gap_micros = now - step_time_micros;            // allow tracking how often the stepper steps
     step_time_micros = now;
+    if (queue_active) direction = target_position > position? DIR_CW : DIR_CCW;
     nextPhase();                                         // send the next phase signal to the controller
+    writeOutput();
+    if (!queue_active) target_position = position;       // keep the target in sync for free stepping
     return 1;                                            // and confirm the step to the caller.
 }
 
+// setGovernor enables or disables the speed governor.
+// The governor tracks the call gap of step() and caps the RPM to the highest RPM the
+// loop can sustain, so that the stepper runs at a predictable speed under load
+// instead of silently slowing down. Use getThrottling to check if the RPM is capped.
+void SmoothStepper::setGovernor(bool enabled) {
+    governor = enabled;
+    governor_rpm = 0;
+    gap_block_max = 0;
+    gap_prev_max = 0;
+    gap_block_calls = 0;
+    setRPM(requested_rpm);
+}
+
+// observeCallGap updates the max call gap and the sustainable RPM after each window block.
+// Gaps longer than the step delay at min RPM are pauses of the caller and are ignored.
+void SmoothStepper::observeCallGap(unsigned long gap) {
+    unsigned long rev_steps = getStepsPerRev();
+    if (gap > MINUTE / rev_steps / min_rmp) return;
+    if (gap > gap_block_max) gap_block_max = gap;
+    if (++gap_block_calls < GOVERNOR_WINDOW) return;
+
+    unsigned long max_gap = max(gap_block_max, gap_prev_max);
+    max_gap += max_gap >> 3;                              // keep 12.5% headroom
+    unsigned long sustainable = max_gap > 0? MINUTE / rev_steps / max_gap : max_rmp;
+    // even the slowest loop caps the RPM, 0 would mean unknown and disable the cap
+    governor_rpm = constrain(sustainable, (unsigned long)min_rmp, (unsigned long)max_rmp);
+    gap_prev_max = gap_block_max;
+    gap_block_max = 0;
+    gap_block_calls = 0;
+    int rpm = min(requested_rpm, governor_rpm);
+    if (rpm != this->rpm) setRPM(requested_rpm);          // throttle or restore the RPM
+}
+
+// setClockPolicy selects how step() schedules the steps: CLOCK_FREE, CLOCK_BURST,
+// CLOCK_SKIP, or CLOCK_CLAMP.
+// With CLOCK_FREE, the next step is due step_delay_micros after the last step, so any lateness
+// of the caller slows down the stepper. The other policies advance a fixed deadline by
+// step_delay_micros on every step, so the stepper keeps the RPM set via setRPM as long as the
+// loop can keep up. They differ in how missed deadlines are handled.
+void SmoothStepper::setClockPolicy(int policy) {
+    if (policy < CLOCK_FREE || policy > CLOCK_CLAMP) policy = CLOCK_FREE;
+    clock_policy = policy;
+    step_deadline_micros = micros();
+}
+
+// resetClockStats resets the lateness statistics.
+void SmoothStepper::resetClockStats() {
+    late_min_micros = 0;
+    late_max_micros = 0;
+    late_sum_micros = 0;
+    late_count = 0;
+    missed_deadlines = 0;
+}
+
+// observeLateness records the lateness of a step.
+void SmoothStepper::observeLateness(unsigned long late) {
+    if (late_count == 0 || late < late_min_micros) late_min_micros = late;
+    if (late > late_max_micros) late_max_micros = late;
+    if (late_sum_micros > 0x7FFFFFFFUL) {  // halve sum and count to avoid overflows, keeps the mean
+        late_sum_micros >>= 1;
+        late_count >>= 1;
+    }
+    late_sum_micros += late;
+    late_count++;
+    if (late >= step_delay_micros) missed_deadlines++;
+}
+
+// clockStep returns true if the next step is due and advances the step clock.
+// Pauses of the caller (see pause) and gaps longer than CLOCK_MAX_BACKLOG step delays
+// restart the clock and are not observed as lateness.
+bool SmoothStepper::clockStep(unsigned long now) {
+    unsigned long gap = now - step_time_micros;
+    bool restart = !active || paused || gap > CLOCK_MAX_BACKLOG * step_delay_micros;
+    if (clock_policy == CLOCK_FREE) {
+        if (gap < step_delay_micros) return false;
+        if (!restart) observeLateness(gap - step_delay_micros);
+        return true;
+    }
+    if (restart) step_deadline_micros = now;            // (re)start the clock with the first step
+    long late = (long)(now - step_deadline_micros);
+    if (late < 0) return false;
+    if (clock_policy == CLOCK_CLAMP && gap < (step_delay_micros >> 1)) {
+        return false;                                   // catch up at max twice the speed
+    }
+    if (!restart) observeLateness(late);
+    step_deadline_micros += step_delay_micros;          // advance the ideal step time
+    if ((unsigned long)late >= step_delay_micros) {     // missed the next deadline as well
+        if (clock_policy == CLOCK_SKIP || (unsigned long)late >= CLOCK_MAX_BACKLOG * step_delay_micros) {
+            step_deadline_micros = now + step_delay_micros;  // drop the missed steps
+        }
+    }
+    return true;
+}
+
+// queueMove queues a move of @steps steps in the given direction at the given RPM
+// (0 keeps the current RPM). It returns false if the queue is full.
+// Queued moves are drained in the background by calling step(). In timer mode, step() only
+// starts the queued moves and the timer interrupt steps towards their target.
+// Consecutive moves in the same direction are joined before the current move ends,
+// so that the stepper keeps its speed across the move boundary.
+bool SmoothStepper::queueMove(long steps, int dir, int rpm) {
+    if (queue_count >= MOVE_QUEUE_SIZE) return false;
+    if (steps <= 0) return true;  // nothing to do
+    StepperMove &m = move_queue[(queue_head + queue_count) & (MOVE_QUEUE_SIZE - 1)];
+    m.steps = steps;
+    m.direction = dir == DIR_CCW? DIR_CCW : DIR_CW;
+    m.rpm = constrain(rpm, 0, 255);
+    queue_count++;
+    return true;
+}
+
+// clearQueue drops all queued moves that have not started yet.
+void SmoothStepper::clearQueue() {
+    queue_head = 0;
+    queue_count = 0;
+}
+
+// drainQueue starts queued moves by moving the target position.
+// A move is started when the current move is finished or, if it goes in the same direction,
+// when the remaining distance reaches the steps needed to stop (look-ahead).
+void SmoothStepper::drainQueue() {
+    if (queue_count == 0 && distanceToGo() == 0) queue_active = false;  // all moves finished
+    while (queue_count > 0) {
+        StepperMove &m = move_queue[queue_head];
+        long distance = distanceToGo();
+        if (distance != 0) {
+            bool same_dir = (distance > 0) == (m.direction == DIR_CW);
+            if (!same_dir || labs(distance) > ramp_steps + 1) return;
+        }
+        if (m.rpm > 0) setRPM(m.rpm);
+        if (distance == 0 && profile == PROFILE_NONE) direction = m.direction;
+        move(m.direction == DIR_CW? m.steps : -m.steps);
+        queue_active = true;
+        queue_head = (queue_head + 1) & (MOVE_QUEUE_SIZE - 1);
+        queue_count--;
+    }
+}
+
+// stepNow steps once in the current direction, ignoring the step delay.
+// It allows external schedulers, such as the StepperGroup, to drive the stepper.
+void SmoothStepper::stepNow(unsigned long now) {
+    step_gap_micros = now - step_time_micros;
+    step_time_micros = now;
+    nextPhase();
+    target_position = position;  // keep the target in sync for external stepping
+}
+
 // turn steps num_steps in the current direction and will block the execution until finished.
 // It returns the absolute number of steps stepped, i.e. the original value of @steps.
 // @param num_steps absolute number of steps to step.
 int SmoothStepper::turn(unsigned int num_steps) {
-    if (num_steps > 0) {
+    if (num_steps > 0 && timer_mode) {
+        move(direction == DIR_CW? (long)num_steps : -(long)num_steps);
+        while (distanceToGo() != 0) {}  // will block execution until the timer finished
+        delayMicroseconds(step_delay_micros);
+    } else if (num_steps > 0 && profile != PROFILE_NONE) {
+        move(direction == DIR_CW? (long)num_steps : -(long)num_steps);
+        while (distanceToGo() != 0) step();  // will block execution until the ramp finished
+        delayMicroseconds(step_delay_micros);
+    } else if (num_steps > 0) {
         int i = num_steps;
         while (i > 0) i = i - step();  // will block execution until finished
 
@@ -75,58 +276,394 @@ int SmoothStepper::turn(unsigned int num_steps) {
 // stop turns off all controller pins.
 // After finishing your movement, always call stop to avoid heating up the stepper!
 void SmoothStepper::stop(){
-    if (active) {
-        digitalWrite(pin_1, LOW);
-        digitalWrite(pin_2, LOW);
-        digitalWrite(pin_3, LOW);
-        digitalWrite(pin_4, LOW);
-        active = false;
+    clearQueue();                    // cancel pending moves
+    queue_active = false;            // and return to free stepping via step()
+    STEPPER_ATOMIC {
+        target_position = position;  // cancel pending timer steps
+        if (active) {
+            coilsOff();
+            active = false;
+        }
     }
 }
 
-// nextPhase advances the stepper signal to the next signal phase.
-void SmoothStepper::nextPhase() {
-    int phase = this->phase;
-    if (direction == DIR_CW) {
-        if (phase == PHASE_3) phase = PHASE_0;
-        else                  phase++;
+// coilsOff turns off all coils.
+void SmoothStepper::coilsOff() {
+    if (shift_output != NULL) {
+        shift_output->setNibble(shift_slot, 0);
+        shift_output->update();
+        return;
+    }
+#if defined(__AVR__)
+    if (phase_port != NULL) {
+        STEPPER_ATOMIC { *phase_port &= ~phase_mask; }
+        return;
+    }
+#endif
+    digitalWrite(pin_1, LOW);
+    digitalWrite(pin_2, LOW);
+    digitalWrite(pin_3, LOW);
+    digitalWrite(pin_4, LOW);
+}
+
+// setPower configures the power management of the coils after the last step.
+// After @hold_micros the current is reduced to @hold_duty/255 via PWM, and after
+// @release_micros the coils are de-energized. The next step re-energizes the coils.
+// A @hold_micros of 0 disables the power management, a @release_micros of 0 keeps holding.
+// Both delays are at least HOLD_MIN_STEPS step delays of the current RPM, so that slow
+// stepping never reduces the current between two steps.
+void SmoothStepper::setPower(unsigned long hold_micros, uint8_t hold_duty, unsigned long release_micros) {
+    this->hold_micros = hold_micros;
+    this->hold_duty = hold_duty;
+    this->release_micros = release_micros;
+}
+
+// setEnablePin sets a PWM pin connected to the enable input of the driver.
+// Without an enable pin, the holding current is reduced by switching the coils via software
+// PWM with a period of HOLD_PWM_PERIOD, which requires updatePower to be called often enough.
+void SmoothStepper::setEnablePin(int pin) {
+    enable_pin = pin;
+    if (enable_pin >= 0) {
+        pinMode(enable_pin, OUTPUT);
+        digitalWrite(enable_pin, HIGH);
+    }
+}
+
+// updatePower reduces or turns off the coil current if the stepper did not step for a while.
+// It does not block and must be called in every loop, also while not stepping.
+void SmoothStepper::updatePower() {
+    if (hold_micros == 0 || !active) return;
+    if (getTargetMode() && distanceToGo() != 0) return;  // the timer or profile is stepping
+    unsigned long now = micros();
+    unsigned long idle = now - step_time_micros;
+    unsigned long min_idle = HOLD_MIN_STEPS * step_delay_micros;
+    if (idle < hold_micros || idle < min_idle) return;
+
+    if (release_micros > 0 && idle >= release_micros) {
+        if (power_state == POWER_OFF) return;
+        power_state = POWER_OFF;
+        if (enable_pin >= 0) digitalWrite(enable_pin, LOW);
+        coilsOff();
+        return;
+    }
+
+    if (power_state != POWER_HOLD) {
+        power_state = POWER_HOLD;
+        if (enable_pin >= 0) analogWrite(enable_pin, hold_duty);
+    }
+    if (enable_pin < 0) {
+        // software PWM: coils are on for the first hold_duty/256 of each period
+        unsigned long on_micros = (unsigned long)hold_duty * HOLD_PWM_PERIOD >> 8;
+        holdCoils((now & (HOLD_PWM_PERIOD - 1)) < on_micros);
+    }
+}
+
+// holdCoils switches the coils of the current phase on or off for the software PWM.
+void SmoothStepper::holdCoils(bool on) {
+    if (on == hold_coils_on) return;
+    hold_coils_on = on;
+    if (on) runPhase(phase);
+    else    coilsOff();
+    writeOutput();
+}
+
+// writeOutput transfers the frame of the shift register output, if any.
+void SmoothStepper::writeOutput() {
+    if (shift_output != NULL) shift_output->update();
+}
+
+// startTimer starts stepping from the Timer1 compare interrupt every step_delay_micros.
+// In timer mode, step() is a no-op and the motor moves towards the target set via
+// move() or moveTo(), independent of how often the loop runs.
+// It returns false if the timer is not available (see STEPPER_USE_TIMER).
+// Timer1 also provides the PWM of pins 9 and 10 (Uno). startTimer returns false if
+// analogWrite already uses these pins, and analogWrite must not be used on them while
+// the timer is stepping, since it would change the step period.
+bool SmoothStepper::startTimer() {
+#ifdef STEPPER_TIMER_ENABLED
+    if (TCCR1A & (_BV(COM1A1) | _BV(COM1A0) | _BV(COM1B1) | _BV(COM1B0))) return false;  // PWM on pin 9 or 10
+    STEPPER_ATOMIC {
+        timer_stepper = this;
+        target_position = position;
+        timer_mode = true;
+        TCCR1A = 0;                  // no PWM output, CTC mode is set in setTimerDelay
+        TCNT1 = 0;
+        setTimerDelay();
+        TIMSK1 |= _BV(OCIE1A);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+// stopTimer stops the timer interrupt and returns to polled stepping via step().
+void SmoothStepper::stopTimer() {
+#ifdef STEPPER_TIMER_ENABLED
+    STEPPER_ATOMIC {
+        TIMSK1 &= ~_BV(OCIE1A);
+        timer_mode = false;
+        target_position = position;
+    }
+#endif
+}
+
+// setTimerDelay sets the Timer1 compare value to step_delay_micros.
+// It uses a prescaler of 64 (4 micros resolution at 16 MHz) up to 262 ms per step
+// and a prescaler of 256 for slower speeds.
+void SmoothStepper::setTimerDelay() {
+#ifdef STEPPER_TIMER_ENABLED
+    unsigned long ticks = (step_delay_micros * (F_CPU / 1000000L)) >> 6;
+    uint8_t prescaler = _BV(CS11) | _BV(CS10);
+    if (ticks > 0xFFFF) {
+        ticks = ticks >> 2;
+        prescaler = _BV(CS12);
+    }
+    ticks = constrain(ticks, 1, 0xFFFF);
+    STEPPER_ATOMIC {
+        OCR1A = ticks - 1;
+        TCCR1B = _BV(WGM12) | prescaler;  // CTC mode, count up to OCR1A
+        if (TCNT1 > OCR1A) TCNT1 = 0;     // don't miss the compare match after speeding up
+    }
+#endif
+}
+
+// timerStep moves one step towards the target position; called from the timer interrupt.
+void SmoothStepper::timerStep() {
+    long distance = target_position - position;
+    if (distance == 0) {
+        paused = true;  // the next move starts a new run
+        return;
+    }
+    direction = distance > 0? DIR_CW : DIR_CCW;
+    unsigned long now = micros();
+    step_gap_micros = now - step_time_micros;
+    step_time_micros = now;
+    nextPhase();
+    writeOutput();
+}
+
+// moveTo sets the target position for the timer interrupt or the motion profile.
+void SmoothStepper::moveTo(long target) {
+    STEPPER_ATOMIC { target_position = target; }
+}
+
+// move moves the target position for the timer interrupt or the motion profile by the given number of steps.
+// Positive steps move clockwise (DIR_CW), negative steps counterclockwise.
+void SmoothStepper::move(long steps) {
+    STEPPER_ATOMIC { target_position += steps; }
+}
+
+// setProfile selects the motion profile used by step().
+// With PROFILE_TRAPEZOID or PROFILE_SCURVE, step() moves towards the target position set via
+// move() or moveTo(), accelerating up to the RPM set via setRPM and decelerating to stop at
+// the target. Use setAcceleration (and setJerk for PROFILE_SCURVE) to define the ramps.
+void SmoothStepper::setProfile(int profile) {
+    if (profile != PROFILE_TRAPEZOID && profile != PROFILE_SCURVE) profile = PROFILE_NONE;
+    this->profile = profile;
+    target_position = position;
+    speed_q16 = 0;
+    accel_q24 = 0;
+    step_accum = 0;
+    ramp_steps = 0;
+    profile_time_micros = micros();
+}
+
+// setAcceleration sets the max acceleration in steps/s^2, up to PROFILE_MAX_ACCEL.
+void SmoothStepper::setAcceleration(long steps_per_s2) {
+    steps_per_s2 = constrain(steps_per_s2, 0, PROFILE_MAX_ACCEL);
+    max_accel_q24 = (steps_per_s2 * 17180L) >> 10;           // * 2^24 / 10^6 per micro
+    updateBraking();
+}
+
+// setJerk sets the max change of acceleration in steps/s^3 for PROFILE_SCURVE,
+// up to PROFILE_MAX_JERK.
+void SmoothStepper::setJerk(long steps_per_s3) {
+    steps_per_s3 = constrain(steps_per_s3, 0, PROFILE_MAX_JERK);
+    jerk_q40 = (steps_per_s3 * 1126L) >> 10;                 // * 2^40 / 10^12 per micro^2
+    updateBraking();
+}
+
+// updateBraking precomputes the S-curve braking terms, so that brakeSteps only needs
+// 32-bit multiplications: the jerk time max_accel / jerk, the speed gained while the jerk
+// ramps the acceleration from max to 0, and 1 / (2 * max_accel) with a scale that keeps
+// the factor within 16 bits.
+void SmoothStepper::updateBraking() {
+    int64_t accel = ((int64_t)max_accel_q24 * 1000000L) >> 24;             // steps/s^2
+    jerk_time_q10 = 0;
+    jerk_speed = 0;
+    brake_inv = 0;
+    brake_shift = 0;
+    if (jerk_q40 <= 0 || accel <= 0) return;
+    int64_t micros = ((int64_t)max_accel_q24 << 16) / jerk_q40;
+    jerk_time_q10 = min((micros << 10) / 1000000L, (int64_t)0xFFFF);
+    jerk_speed = (accel * jerk_time_q10) >> 11;                             // a * t / 2
+    while (brake_shift < 32 && (1LL << (16 + brake_shift)) / (2 * accel) < 0x8000) brake_shift++;
+    brake_inv = (1LL << (16 + brake_shift)) / (2 * accel);                 // 2^(16+shift) / 2a
+}
+
+// brakeSteps estimates the steps needed to stop with PROFILE_SCURVE. The jerk swings the
+// acceleration to -max within 1 jerk time, or 2 if still accelerating, which also adds
+// speed; then the max deceleration stops the motor within v^2 / (2 * max_accel) steps.
+long SmoothStepper::brakeSteps() {
+    unsigned long speed = speed_q16 >> 16;
+    unsigned long swing_q10 = jerk_time_q10;
+    if (accel_q24 > 0) {
+        speed += jerk_speed;
+        swing_q10 *= 2;
+    }
+    if (speed > 0xFFFF) speed = 0xFFFF;                   // keep the products within 32 bits
+    if (swing_q10 > 0xFFFF) swing_q10 = 0xFFFF;
+    unsigned long swing_steps = (speed * swing_q10) >> 10;
+    unsigned long stop_steps = (speed * ((speed * brake_inv) >> 16)) >> brake_shift;
+    return swing_steps + stop_steps;
+}
+
+// profileStep updates speed and acceleration of the motion profile and steps towards the
+// target position if the integrated speed reached one step. It uses fixed-point integer
+// arithmetic only: the speed is integrated over the elapsed time and no per-step interval
+// has to be computed via division.
+int SmoothStepper::profileStep(unsigned long now) {
+    unsigned long dt = now - profile_time_micros;
+    profile_time_micros = now;
+    if (dt > PROFILE_MAX_DT) dt = PROFILE_MAX_DT;
+
+    long distance = target_position - position;
+    if (distance == 0) {                                  // target reached, stop
+        speed_q16 = 0;
+        accel_q24 = 0;
+        step_accum = 0;
+        ramp_steps = 0;
+        return 0;
+    }
+
+    int dir = distance > 0? DIR_CW : DIR_CCW;
+    if (speed_q16 <= min_speed_q16) direction = dir;      // only reverse at start/stop speed
+    long remaining = dir == direction? labs(distance) : 0;
+
+    long brake_steps = ramp_steps;
+    if (profile == PROFILE_SCURVE) brake_steps = max(brake_steps, brakeSteps());
+
+    // decelerate to stop at the target, when reversing, or when above the cruise speed
+    long target_accel;
+    if (remaining <= brake_steps) {
+        target_accel = -max_accel_q24;
+        if (ramp_steps < remaining) ramp_steps = remaining;  // keep braking until the target
+    }
+    else if (speed_q16 > max_speed_q16)  target_accel = -max_accel_q24;
+    else if (speed_q16 < max_speed_q16)  target_accel = max_accel_q24;
+    else                                 target_accel = 0;
+
+    if (profile == PROFILE_SCURVE) {                      // ramp the acceleration with the jerk
+        long jerk = (jerk_q40 * (long)dt) >> 16;
+        if      (accel_q24 + jerk < target_accel) accel_q24 += jerk;
+        else if (accel_q24 - jerk > target_accel) accel_q24 -= jerk;
+        else                                      accel_q24 = target_accel;
     } else {
-        if (phase == PHASE_0) phase = PHASE_3;
-        else                  phase--;
+        accel_q24 = target_accel;
     }
+
+    long speed = speed_q16 + ((accel_q24 * (long)dt) >> 8);  // fits 32 bits up to PROFILE_MAX_ACCEL
+    if (accel_q24 > 0 && speed > max_speed_q16) speed = max(max_speed_q16, speed_q16);
+    if (speed < min_speed_q16) speed = min_speed_q16;
+    speed_q16 = speed;
+
+    step_accum += (unsigned long)(speed_q16 >> 8) * dt;   // steps/s * micros as Q8
+    if (step_accum < (1000000UL << 8)) return 0;          // not yet one full step
+    step_accum -= 1000000UL << 8;
+    if (step_accum >= (1000000UL << 8)) step_accum = 0;   // never burst to catch up
+
+    if (accel_q24 > 0)                         ramp_steps++;
+    else if (accel_q24 < 0 && ramp_steps > 0)  ramp_steps--;
+
+    step_gap_micros = now - step_time_micros;
+    step_time_micros = now;
+    nextPhase();
+    writeOutput();
+    return 1;
+}
+
+// nextPhase advances the stepper signal to the next signal phase of the current sequence.
+// The half-step sequence walks all phases, the full-step and wave-drive sequences skip
+// every other phase.
+void SmoothStepper::nextPhase() {
+    int stride = sequence == SEQUENCE_HALF? 1 : 2;
+    int phase = this->phase;
+    if (direction == DIR_CW) phase += stride;
+    else                     phase -= stride;
+    phase &= PHASE_COUNT - 1;  // wrap around, PHASE_COUNT is a power of two
     this->phase = phase;
+    position += direction == DIR_CW? 1 : -1;
+#ifdef STEPPER_HISTOGRAM
+    // profiles change the step interval on purpose, the first step of a run has no interval;
+    // stalls of the caller are kept, they are the tail of the distribution
+    unsigned long gap = step_gap_micros;
+    if (active && !paused && profile == PROFILE_NONE) {
+        step_histogram.observe(gap > step_delay_micros? gap - step_delay_micros : step_delay_micros - gap);
+    }
+#endif
+    paused = false;
     if (!active) active = true;
+    if (power_state != POWER_ON) {  // re-energize after holding or releasing
+        power_state = POWER_ON;
+        hold_coils_on = true;
+        if (enable_pin >= 0) digitalWrite(enable_pin, HIGH);
+    }
     runPhase(phase);
 }
 
+// runPhase applies the coil pattern of the given phase.
+// With a shift register output, it only updates the stepper's nibble of the output frame.
+// If all pins share one port, the pattern is applied with a single masked write to the
+// port, so that all coils switch at the same time. Otherwise, it falls back to digitalWrite.
 void SmoothStepper::runPhase(int phase) {
-    switch (phase) {
-    case PHASE_0:  // 1010
-        digitalWrite(pin_1, HIGH);
-        digitalWrite(pin_2, LOW);
-        digitalWrite(pin_3, HIGH);
-        digitalWrite(pin_4, LOW);
-        break;
-    case PHASE_1:  // 0110
-        digitalWrite(pin_1, LOW);
-        digitalWrite(pin_2, HIGH);
-        digitalWrite(pin_3, HIGH);
-        digitalWrite(pin_4, LOW);
-        break;
-    case PHASE_2:  //0101
-        digitalWrite(pin_1, LOW);
-        digitalWrite(pin_2, HIGH);
-        digitalWrite(pin_3, LOW);
-        digitalWrite(pin_4, HIGH);
-        break;
-    case PHASE_3:  //1001
-        digitalWrite(pin_1, HIGH);
-        digitalWrite(pin_2, LOW);
-        digitalWrite(pin_3, LOW);
-        digitalWrite(pin_4, HIGH);
-        break;
-    default:
+    if (phase < 0 || phase >= PHASE_COUNT) {
         Serial.print("invalid phase:");
         Serial.println(phase);
+        return;
+    }
+    if (shift_output != NULL) {
+        shift_output->setNibble(shift_slot, PHASE_COILS[phase]);
+        return;
+    }
+#if defined(__AVR__)
+    if (phase_port != NULL) {
+        uint8_t bits = phase_bits[phase];
+        STEPPER_ATOMIC { *phase_port = (*phase_port & ~phase_mask) | bits; }
+        return;
+    }
+#endif
+    uint8_t coils = PHASE_COILS[phase];
+    digitalWrite(pin_1, coils & COIL_1? HIGH : LOW);
+    digitalWrite(pin_2, coils & COIL_2? HIGH : LOW);
+    digitalWrite(pin_3, coils & COIL_3? HIGH : LOW);
+    digitalWrite(pin_4, coils & COIL_4? HIGH : LOW);
+}
+
+// setupPhasePort resolves the output port and bit masks of the pins and precomputes the
+// port bits of each phase. The fast path is only used if all pins share the same port.
+void SmoothStepper::setupPhasePort() {
+#if defined(__AVR__)
+    uint8_t port = digitalPinToPort(pin_1);
+    if (port == NOT_A_PIN ||
+        digitalPinToPort(pin_2) != port ||
+        digitalPinToPort(pin_3) != port ||
+        digitalPinToPort(pin_4) != port) {
+        phase_port = NULL;  // pins span ports, use digitalWrite
+        return;
+    }
+    uint8_t mask_1 = digitalPinToBitMask(pin_1);
+    uint8_t mask_2 = digitalPinToBitMask(pin_2);
+    uint8_t mask_3 = digitalPinToBitMask(pin_3);
+    uint8_t mask_4 = digitalPinToBitMask(pin_4);
+    phase_mask = mask_1 | mask_2 | mask_3 | mask_4;
+    for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+        uint8_t coils = PHASE_COILS[i];
+        phase_bits[i] = (coils & COIL_1? mask_1 : 0) |
+                        (coils & COIL_2? mask_2 : 0) |
+                        (coils & COIL_3? mask_3 : 0) |
+                        (coils & COIL_4? mask_4 : 0);
     }
+    phase_port = portOutputRegister(port);
+#endif
 }
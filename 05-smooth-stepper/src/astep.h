@@ -6,9 +6,89 @@
 #define PHASE_1 1
 #define PHASE_2 2
 #define PHASE_3 3
+#define PHASE_4 4
+#define PHASE_5 5
+#define PHASE_6 6
+#define PHASE_7 7
+#define PHASE_COUNT 8
+
+#define COIL_1 0x1  // pin_1
+#define COIL_2 0x2  // pin_2
+#define COIL_3 0x4  // pin_3
+#define COIL_4 0x8  // pin_4
+
+// PHASE_COILS holds the energized coils of each phase of the half-step sequence.
+// The full-step sequence uses the even phases (two coils) and
+// the wave-drive sequence uses the odd phases (one coil).
+static const uint8_t PHASE_COILS[PHASE_COUNT] = {
+    COIL_1 | COIL_3,  // PHASE_0: 1010
+    COIL_3,           // PHASE_1: 0010
+    COIL_2 | COIL_3,  // PHASE_2: 0110
+    COIL_2,           // PHASE_3: 0100
+    COIL_2 | COIL_4,  // PHASE_4: 0101
+    COIL_4,           // PHASE_5: 0001
+    COIL_1 | COIL_4,  // PHASE_6: 1001
+    COIL_1,           // PHASE_7: 1000
+};
+
+#define SEQUENCE_FULL 0  // two coils per step, max torque
+#define SEQUENCE_HALF 1  // alternating one and two coils, doubles the steps per rotation
+#define SEQUENCE_WAVE 2  // one coil per step, half the coil current for light loads
 
 #define MAX_SPEED_28BYJ_48 15 // 28BYJ-48 runs stable at 15 - 17 RPM
 
+#define PROFILE_NONE      0   // constant speed, step() steps in the current direction
+#define PROFILE_TRAPEZOID 1   // constant acceleration towards the target position
+#define PROFILE_SCURVE    2   // jerk-limited acceleration towards the target position
+
+#define PROFILE_MAX_DT 4000L  // max micros integrated per profile update (limits overflows)
+#define PROFILE_MAX_ACCEL 31000L   // max acceleration in steps/s^2, accel * PROFILE_MAX_DT fits 32 bits
+#define PROFILE_MAX_JERK  480000L  // max jerk in steps/s^3, jerk * PROFILE_MAX_DT fits 32 bits
+
+#define CLOCK_FREE  0          // next step is due step_delay_micros after the last step (default)
+#define CLOCK_BURST 1          // fixed deadlines, missed steps are caught up on the next calls
+#define CLOCK_SKIP  2          // fixed deadlines, missed steps are dropped
+#define CLOCK_CLAMP 3          // fixed deadlines, missed steps are caught up at max twice the speed
+
+#define CLOCK_MAX_BACKLOG 4    // max steps to catch up before the clock is restarted
+
+#define POWER_ON   0           // coils fully energized
+#define POWER_HOLD 1           // coils energized with reduced holding current (PWM)
+#define POWER_OFF  2           // coils de-energized
+
+#define HOLD_PWM_PERIOD 1024L  // software PWM period in micros, must be a power of two
+#define HOLD_MIN_STEPS  2      // hold no earlier than 2 step delays after the last step
+
+#define GOVERNOR_WINDOW 32     // number of step() calls per window block of the speed governor
+
+#define MOVE_QUEUE_SIZE 8     // max queued moves, must be a power of two
+
+// StepperMove is a queued move of the SmoothStepper.
+struct StepperMove {
+    long steps;               // absolute number of steps
+    uint8_t direction;        // DIR_CW or DIR_CCW
+    uint8_t rpm;              // speed of the move (0 = keep the current RPM)
+};
+
+// Define STEPPER_USE_TIMER to enable the ISR-driven stepping via Timer1 (AVR only).
+#if defined(__AVR__) && defined(STEPPER_USE_TIMER)
+#define STEPPER_TIMER_ENABLED 1
+#endif
+
+// Define STEPPER_HISTOGRAM to record a histogram of the step interval error.
+#ifdef STEPPER_HISTOGRAM
+#include "histogram.h"
+#endif
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#define STEPPER_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define STEPPER_ATOMIC
+#endif
+
+class ShiftOutput;
+
 class SmoothStepper {
 private:
     int pin_1;
@@ -16,20 +96,89 @@ private:
     int pin_3;
     int pin_4;
     int motor_steps;
-    int phase = PHASE_0;
-    int direction = DIR_CW;
+    ShiftOutput *shift_output = NULL;     // shift register output (NULL = use the pins)
+    uint8_t shift_slot = 0;               // nibble of the stepper in the shift register frame
+    volatile int phase = PHASE_0;         // written by the timer interrupt (timer mode)
+    int sequence = SEQUENCE_FULL;
+    volatile int direction = DIR_CW;      // written by the timer interrupt (timer mode)
     int rpm = 1;
+    int requested_rpm = 1;                // RPM set via setRPM, before applying the governor
     int max_rmp = MAX_SPEED_28BYJ_48;
     int min_rmp = 1;
-    bool active = false;
+    volatile bool active = false;         // written by the timer interrupt (timer mode)
+    bool timer_mode = false;
+    volatile long position = 0;
+    volatile long target_position = 0;
     unsigned long step_time_micros = 0;
     unsigned long step_gap_micros = 0;
     unsigned long step_delay_micros = 0;
     unsigned long step_call_gap_micros = 0;
     unsigned long step_call_time_micros = 0;
+    // motion profile state, speeds in steps/s as Q16.16, accelerations per micro as Q8.24
+    int profile = PROFILE_NONE;
+    long speed_q16 = 0;                   // current speed
+    long min_speed_q16 = 0;               // start/stop speed (min_rpm)
+    long max_speed_q16 = 0;               // cruise speed (rpm)
+    long accel_q24 = 0;                   // current acceleration
+    long max_accel_q24 = 0;               // max acceleration
+    long jerk_q40 = 0;                    // change of acceleration per micro (S-curve)
+    unsigned long jerk_time_q10 = 0;      // seconds to ramp the acceleration from 0 to max (S-curve)
+    unsigned long jerk_speed = 0;         // steps/s gained while ramping the acceleration to 0
+    unsigned long brake_inv = 0;          // 2^(16 + brake_shift) / (2 * max acceleration)
+    uint8_t brake_shift = 0;
+    unsigned long step_accum = 0;         // integrated speed since the last step
+    unsigned long profile_time_micros = 0;
+    long ramp_steps = 0;                  // steps taken while accelerating (= steps needed to stop)
+    // step clock, lateness is measured against the ideal step time
+    int clock_policy = CLOCK_FREE;
+    unsigned long step_deadline_micros = 0;  // ideal time of the next step
+    unsigned long late_min_micros = 0;
+    unsigned long late_max_micros = 0;
+    unsigned long late_sum_micros = 0;
+    unsigned long late_count = 0;
+    unsigned long missed_deadlines = 0;      // steps later than a full step delay
+    // power management, timed from the last step
+    int power_state = POWER_ON;
+    int enable_pin = -1;                     // PWM pin of the driver's enable input (-1 = PWM the coils)
+    uint8_t hold_duty = 0;                   // holding current as duty cycle (0-255)
+    unsigned long hold_micros = 0;           // idle time before reducing the current (0 = disabled)
+    unsigned long release_micros = 0;        // idle time before de-energizing (0 = never)
+    bool hold_coils_on = true;               // current software PWM output
+    // speed governor, tracks the max call gap over the last one to two window blocks
+    bool governor = false;
+    int governor_rpm = 0;                    // max sustainable RPM (0 = unknown)
+    unsigned long gap_block_max = 0;         // max call gap of the current block
+    unsigned long gap_prev_max = 0;          // max call gap of the previous block
+    uint8_t gap_block_calls = 0;
+#ifdef STEPPER_HISTOGRAM
+    Histogram step_histogram;                // step interval error relative to step_delay_micros
+#endif
+    bool paused = false;                     // the caller had no pending steps, the next step starts a new run
+    // queued moves, drained by step() in the background
+    StepperMove move_queue[MOVE_QUEUE_SIZE];
+    uint8_t queue_head = 0;
+    uint8_t queue_count = 0;
+    bool queue_active = false;            // stepping towards the target of queued moves
+#if defined(__AVR__)
+    volatile uint8_t *phase_port = NULL;  // output register of all pins (NULL=pins span ports)
+    uint8_t phase_mask = 0;               // port bits of all pins
+    uint8_t phase_bits[PHASE_COUNT];      // port bits of each phase
+#endif
     void nextPhase();
     void runPhase(int phase);
     void setup();
+    void setupPhasePort();
+    void setTimerDelay();
+    int profileStep(unsigned long now);
+    void updateBraking();
+    long brakeSteps();
+    void drainQueue();
+    bool clockStep(unsigned long now);
+    void observeCallGap(unsigned long gap);
+    void coilsOff();
+    void holdCoils(bool on);
+    void writeOutput();
+    void observeLateness(unsigned long late);
 public:
     inline SmoothStepper(int num_steps, int pin1, int pin2, int pin3, int pin4) {
         motor_steps = max(1, num_steps);
@@ -39,25 +188,100 @@ public:
         pin_4 = pin4;
         setup();
     }
+    // SmoothStepper with the coils driven via a slot of daisy-chained shift registers.
+    // step(), stop(), and updatePower() transfer the frame after changing the outputs.
+    // stepNow() only updates the frame; external schedulers call output->update() after
+    // stepping all steppers, so that their outputs switch at once.
+    inline SmoothStepper(int num_steps, ShiftOutput *output, uint8_t slot) {
+        motor_steps = max(1, num_steps);
+        pin_1 = pin_2 = pin_3 = pin_4 = -1;
+        shift_output = output;
+        shift_slot = slot;
+        setup();
+    }
     ~SmoothStepper() {}
     int step();
+    void stepNow(unsigned long now);
     int turn(unsigned int steps);
     void stop();
+    // pause tells the stepper that the caller has no pending steps, e.g., while waiting for the
+    // next key repeat; the next step restarts the clock and its interval is not an error.
+    void pause() { paused = true; }
     void setRPM(int rpm);
     void setRPMRange(int min_rpm, int max_rpm);
     void setDir(int dir);
+    void setSequence(int sequence);
+
+    // ISR-driven stepping (requires STEPPER_USE_TIMER)
+    bool startTimer();
+    void stopTimer();
+    void timerStep();
+    void moveTo(long target);
+    void move(long steps);
+
+    // motion profiles (polled stepping via step())
+    void setProfile(int profile);
+    void setAcceleration(long steps_per_s2);
+    void setJerk(long steps_per_s3);
+
+    // power management (call updatePower in every loop)
+    void setPower(unsigned long hold_micros, uint8_t hold_duty, unsigned long release_micros);
+    void setEnablePin(int pin);
+    void updatePower();
+
+    // speed governor (polled stepping via step())
+    void setGovernor(bool enabled);
+
+    // step clock (polled constant speed stepping via step())
+    void setClockPolicy(int policy);
+    void resetClockStats();
+
+    // queued moves (non-blocking alternative to turn(), drained by calling step())
+    bool queueMove(long steps, int dir, int rpm = 0);
+    void clearQueue();
 
     // increases RPM by 1 up to the max_rpm.
-    void incRPM() { setRPM(rpm + 1); }
+    void incRPM() { setRPM(requested_rpm + 1); }
     // decreases RPM by 1 down to the min_rmp.
-    void decRPM() { setRPM(rpm - 1); }
+    void decRPM() { setRPM(requested_rpm - 1); }
 
     int           getRPM()     { return rpm; }
     int           getDir()     { return direction; }
     unsigned long getCallGap() { return step_call_gap_micros; }
     unsigned long getStepGap() { return step_gap_micros; }
     int           getPhase()   { return phase; }
+    int           getSequence() { return sequence; }
+    // getStepsPerRev returns the steps of a full rotation in the current sequence.
+    long          getStepsPerRev() { return sequence == SEQUENCE_HALF? 2L * motor_steps : motor_steps; }
     bool          getActive()  { return active; }
+    bool          getTimerMode() { return timer_mode; }
+    // getTargetMode returns true if the stepper moves towards the target position (timer or profile).
+    bool          getTargetMode() { return timer_mode || profile != PROFILE_NONE; }
+    int           getProfile()   { return profile; }
+    long          getSpeed()     { return speed_q16 >> 16; }  // current speed in steps/s
+    long          getRampSteps() { return ramp_steps; }
+    int           getPowerState()   { return power_state; }
+    bool          getGovernor()     { return governor; }
+    int           getGovernorRPM()  { return governor_rpm; }
+    // getThrottling returns true if the governor caps the RPM below the requested RPM.
+    bool          getThrottling()   { return rpm < requested_rpm; }
+    int           getClockPolicy()  { return clock_policy; }
+    unsigned long getLateMin()      { return late_min_micros; }
+    unsigned long getLateMax()      { return late_max_micros; }
+    unsigned long getLateMean()     { return late_count != 0? late_sum_micros / late_count : 0; }
+    unsigned long getMissedDeadlines() { return missed_deadlines; }
+#ifdef STEPPER_HISTOGRAM
+    // getStepHistogram returns a copy of the histogram of the absolute step interval error in micros,
+    // taken atomically since the timer interrupt observes the steps in timer mode.
+    Histogram     getStepHistogram()   { Histogram h; STEPPER_ATOMIC { h = step_histogram; } return h; }
+    void          resetStepHistogram() { STEPPER_ATOMIC { step_histogram.reset(); } }
+#endif
+    uint8_t       queueDepth()   { return queue_count; }
+    // queueDone returns true if all queued moves are finished.
+    bool          queueDone()    { return queue_count == 0 && distanceToGo() == 0; }
+    long          getPosition()  { long p; STEPPER_ATOMIC { p = position; } return p; }
+    long          getTarget()    { long t; STEPPER_ATOMIC { t = target_position; } return t; }
+    long          distanceToGo() { long d; STEPPER_ATOMIC { d = target_position - position; } return d; }
 
     const char* dirName() {
         switch (direction) {
@@ -67,4 +291,22 @@ public:
             default:              return "UNKNOWN";
         }
     }
+
+    const char* sequenceName() {
+        switch (sequence) {
+            case SEQUENCE_FULL: return "SEQUENCE_FULL";
+            case SEQUENCE_HALF: return "SEQUENCE_HALF";
+            case SEQUENCE_WAVE: return "SEQUENCE_WAVE";
+            default:            return "UNKNOWN";
+        }
+    }
+
+    const char* powerName() {
+        switch (power_state) {
+            case POWER_ON:   return "POWER_ON";
+            case POWER_HOLD: return "POWER_HOLD";
+            case POWER_OFF:  return "POWER_OFF";
+            default:         return "UNKNOWN";
+        }
+    }
 };
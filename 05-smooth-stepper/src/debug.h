@@ -1,6 +1,7 @@
-
+// stepper_debug adds a deferred log record (message ID and one argument),
+// requires a DeferredLog named Log.
 #ifdef DEBUG_STEPPER
-#define stepper_debug(text) print(text)
+#define stepper_debug(id, arg) Log.add(id, arg)
 #else
-#define stepper_debug(text) void()
+#define stepper_debug(id, arg) void()
 #endif
@@ -0,0 +1,36 @@
+#include "Arduino.h"
+#include "deferlog.h"
+
+// add adds a record with the current micros; it only copies a few bytes and never blocks.
+void DeferredLog::add(uint8_t id, int a, int b) {
+    if (count >= DEFERLOG_SIZE) {
+        if (dropped_records < 0x7FFF) dropped_records++;  // fits the int argument
+        return;
+    }
+    LogRecord &r = records[(head + count) & (DEFERLOG_SIZE - 1)];
+    r.id = id;
+    r.a = a;
+    r.b = b;
+    r.time = micros();
+    count++;
+}
+
+// pop removes the oldest record and returns false if the log is empty.
+bool DeferredLog::pop(LogRecord &record) {
+    if (count == 0) return false;
+    record = records[head];
+    head = (head + 1) & (DEFERLOG_SIZE - 1);
+    count--;
+    return true;
+}
+
+// addDropped adds a record with the number of dropped records as argument a and resets the
+// count. It returns false if nothing was dropped or the log is still full; call it after
+// pop(), so that the count is not lost by being dropped itself.
+bool DeferredLog::addDropped(uint8_t id) {
+    if (dropped_records == 0 || count >= DEFERLOG_SIZE) return false;
+    int n = dropped_records;
+    dropped_records = 0;
+    add(id, n);
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#define DEFERLOG_SIZE 16  // max pending log records, must be a power of two
+
+// LogRecord is a compact log entry: a message ID with two integer arguments.
+struct LogRecord {
+    uint8_t id;
+    int a;
+    int b;
+    unsigned long time;  // micros when the record was added
+};
+
+// DeferredLog stores log records in a fixed ring buffer, so that logging does not block
+// time critical code. The records are sent later via pop(), e.g., while the loop is idle.
+// If the buffer is full, new records are dropped and counted.
+class DeferredLog {
+private:
+    LogRecord records[DEFERLOG_SIZE];
+    uint8_t head = 0;
+    uint8_t count = 0;
+    unsigned int dropped_records = 0;   // dropped since the last addDropped, max 0x7FFF
+public:
+    inline DeferredLog() {}
+    ~DeferredLog() {}
+    void add(uint8_t id, int a = 0, int b = 0);
+    bool pop(LogRecord &record);
+    bool addDropped(uint8_t id);
+
+    uint8_t      size()    { return count; }
+    bool         empty()   { return count == 0; }
+    unsigned int dropped() { return dropped_records; }
+};
@@ -0,0 +1,54 @@
+#include "Arduino.h"
+#include "histogram.h"
+
+void Histogram::reset() {
+    for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) buckets[i] = 0;
+    max_value = 0;
+    total = 0;
+}
+
+// observe counts the value in its bucket.
+void Histogram::observe(unsigned long value) {
+    uint8_t i = bucketOf(value);
+    if (buckets[i] == 0xFFFF) halve();
+    buckets[i]++;
+    total++;
+    if (value > max_value) max_value = value;
+}
+
+// halve halves all buckets, keeping the relative distribution.
+void Histogram::halve() {
+    total = 0;
+    for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        buckets[i] >>= 1;
+        total += buckets[i];
+    }
+}
+
+// percentile returns the upper limit of the bucket containing the given percentile (0-100).
+// The result is capped to the max observed value.
+unsigned long Histogram::percentile(uint8_t percent) {
+    if (total == 0) return 0;
+    unsigned long rank = (total * min(percent, 100) + 99) / 100;  // ceil(total * percent / 100)
+    unsigned long seen = 0;
+    for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) return min(bucketLimit(i), max_value);
+    }
+    return max_value;
+}
+
+// dump prints all non-empty buckets as `name: <limit>:<count> ...` to the Serial.
+void Histogram::dump(const char *name) {
+    Serial.print(name);
+    Serial.print(":");
+    for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        if (buckets[i] == 0) continue;
+        Serial.print(" ");
+        Serial.print(bucketLimit(i));
+        Serial.print(":");
+        Serial.print(buckets[i]);
+    }
+    Serial.print(", max: ");
+    Serial.println(max_value);
+}
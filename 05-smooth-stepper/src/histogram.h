@@ -0,0 +1,34 @@
+#pragma once
+
+#define HISTOGRAM_BUCKETS 24  // bucket i counts values of bit length i, i.e., [2^(i-1), 2^i)
+
+// Histogram counts values in fixed log2 buckets.
+// Observing a value only needs the bit length of the value, no division.
+// Bucket counts are 16 bit; if a bucket saturates, all buckets are halved to keep the
+// distribution, so that the histogram can run for hours without overflows.
+class Histogram {
+private:
+    uint16_t buckets[HISTOGRAM_BUCKETS];
+    unsigned long max_value = 0;
+    unsigned long total = 0;           // sum of all bucket counts
+    void halve();
+public:
+    inline Histogram() { reset(); }
+    ~Histogram() {}
+    void reset();
+    void observe(unsigned long value);
+    unsigned long percentile(uint8_t percent);
+    void dump(const char *name);
+
+    // bucketOf returns the bucket of a value, values above the last bucket are counted in the last bucket.
+    static uint8_t bucketOf(unsigned long value) {
+        uint8_t bits = value == 0? 0 : sizeof(unsigned long) * 8 - __builtin_clzl(value);
+        return bits < HISTOGRAM_BUCKETS? bits : HISTOGRAM_BUCKETS - 1;
+    }
+    // bucketLimit returns the largest value of a bucket.
+    static unsigned long bucketLimit(uint8_t bucket) { return (1UL << bucket) - 1; }
+
+    uint16_t      count(uint8_t bucket) { return bucket < HISTOGRAM_BUCKETS? buckets[bucket] : 0; }
+    unsigned long samples()  { return total; }
+    unsigned long maxValue() { return max_value; }
+};
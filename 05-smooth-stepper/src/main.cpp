@@ -11,29 +11,101 @@
 #include "SignalState.h"    // signal state management
 #include "rgb.h"            // manage RGB LED
 #include "metrics.h"        // basic loop time tracking
-#include "debug.h"          // single debug macro, requires a print(text) function
+#include "debug.h"          // single debug macro, requires a DeferredLog Log
+#include "profiler.h"       // section profiler (requires LOOP_PROFILER)
+#include "telemetry.h"      // binary status frames (requires STEPPER_TELEMETRY)
+#include "deferlog.h"       // deferred logging, drained while idle
 
 // Used Pins
 
 #define SYSTEM_LED_13 13    // LED at pin 13 (built-in LED)
-#define RGB_LED_09     9    // LED at pin 9  (with PWM support)
-#define RGB_LED_10    10    // LED at pin 10 (with PWM support)
+#define RGB_LED_09     9    // LED at pin 9  (with PWM support, on/off only with STEPPER_USE_TIMER)
+#define RGB_LED_10    10    // LED at pin 10 (with PWM support, on/off only with STEPPER_USE_TIMER)
 #define RGB_LED_11    11    // LED at pin 11 (with PWM support)
 #define IR_RECV_7      7    // IR receiver at pin 11
 
+// Log Messages
+
+#define LOG_DROPPED         0  // a: dropped records
+#define LOG_CONTROL         1  // a: command
+#define LOG_INVALID_COMMAND 2  // a: command
+#define LOG_NEGATIVE_STEPS  3  // a: steps
+#define LOG_REPEATING       4  // a: steps
+#define LOG_ACTIVE          5  // a: steps
+#define LOG_WAIT            6  // a: steps
+#define LOG_BAD_STATE       7  // a: state
+
+#define LOG_NAME_MAX 15      // max length of the log names
+
+const char *const log_names[] = {
+    "dropped", "control", "invalid command", "negative steps",
+    "repeating", "active", "wait", "bad state",
+};
+
+// max bytes of a log line or frame, drain only if the TX buffer has room for it
+#ifdef STEPPER_TELEMETRY
+#define LOG_LINE_MAX 22      // SYNC LEN TYPE SEQ, id (1 byte), time, a, b (max 5 bytes each), CK_A CK_B
+#else
+#define LOG_LINE_MAX (22 + LOG_NAME_MAX + 10 + 6 + 6)  // "log: <name>, t: <10>, a: <6>, b: <6>\r\n"
+#endif
+
+#ifdef SERIAL_TX_BUFFER_SIZE
+static_assert(LOG_LINE_MAX < SERIAL_TX_BUFFER_SIZE, "log lines must fit into the Serial TX buffer");
+#endif
+
+// Profiled Sections
+
+#define PROF_DECODE 0       // Receiver.decode
+#define PROF_STATE  1       // State.nextAt
+#define PROF_POWER  2       // Motor.updatePower
+#define PROF_RGB    3       // Rgb updates
+#define PROF_STEP   4       // Motor.step and stop
+#define PROF_RESUME 5       // Receiver.resume
+
+#ifdef LOOP_PROFILER
+const char *const prof_names[] = { "decode", "state", "power", "rgb", "step", "resume" };
+#endif
+
 // Physical Parameters
 
 #define STEPS_FULL       2048  // steps for a full rotation
 #define REPEAT_RANGE  200000L  // defines how fast IR signals can be received (with some added buffer time)
+#define REPEAT_MIN     60000L  // lower bound of the wait period when adapting to the remote's repeat rate
+#define REPEAT_FACTOR     24L  // wait 24/16 = 1.5 times the observed repeat rate before going idle
 #define IDLE_RANGE   1000000L  // After 1 second turn off the Motor
+#define HOLD_TIME      20000L  // reduce the coil current 20 ms (and 2 step delays) after the last step
+#define HOLD_DUTY          64  // holding current as PWM duty cycle (64/255 = 25%)
+#define RELEASE_TIME  150000L  // de-energize the coils 150 ms after the last step
+#define ACCELERATION    1000L  // profile acceleration in steps/s^2
+#define JERK            8000L  // profile jerk in steps/s^3 (PROFILE_SCURVE only)
+
+#ifndef STEPPER_SEQUENCE
+#define STEPPER_SEQUENCE SEQUENCE_FULL  // use SEQUENCE_HALF for smoother or SEQUENCE_WAVE for lighter stepping
+#endif
+
+#ifndef STEPPER_CLOCK
+#define STEPPER_CLOCK CLOCK_FREE  // use CLOCK_BURST, CLOCK_SKIP, or CLOCK_CLAMP for drift-free step timing
+#endif
+
+#ifndef STEPPER_GOVERNOR
+#define STEPPER_GOVERNOR false  // use true to cap the RPM to what the loop can sustain
+#endif
+
+#ifndef STEPPER_PROFILE
+#define STEPPER_PROFILE PROFILE_NONE  // use PROFILE_TRAPEZOID or PROFILE_SCURVE for smooth ramps
+#endif
 
 // Device Management
 
 SmoothStepper Motor(STEPS_FULL, 3,5,4,6);  // stepper controller at pins 3,4,5,6
 IRrecv Receiver(IR_RECV_7);                // IR receiver at pin 11
-SigState State;                            // manage signal state
+SigAdaptive<> State;                       // manage signal state, adapting to the remote's repeat rate
 RgbLed Rgb(RGB_LED_09, RGB_LED_10, RGB_LED_11, RGBLED_COMMON_ANODE);
 LoopMetrics Mx;                            // track execution time of critical loop parts
+DeferredLog Log;                           // log records, sent while the loop is idle
+#ifdef STEPPER_TELEMETRY
+TelemetryWriter Tm;                        // send status as binary frames instead of text
+#endif
 
 int steps = 0;
 int max_steps = 0;
@@ -46,11 +118,23 @@ void setup()
     while (!Serial) delay(100);
 
     Serial.println("# starting stepper setup");
+    Motor.setSequence(STEPPER_SEQUENCE);
     Motor.setRPM(5);
+    Motor.setClockPolicy(STEPPER_CLOCK);
+    Motor.setGovernor(STEPPER_GOVERNOR);
+    Motor.setPower(HOLD_TIME, HOLD_DUTY, RELEASE_TIME);
+    Motor.setProfile(STEPPER_PROFILE);
+    Motor.setAcceleration(ACCELERATION);
+    Motor.setJerk(JERK);
+#ifdef STEPPER_USE_TIMER
+    Rgb.setDigital(true);  // Timer1 steps the motor and cannot provide the PWM of pins 9 and 10
+    if (Motor.startTimer()) Serial.println("# stepping via timer interrupt");
+#endif
     Receiver.begin(IR_RECV_7, ENABLE_LED_FEEDBACK, SYSTEM_LED_13);
     pinMode(SYSTEM_LED_13, OUTPUT);
     State.setIdleSignal(FDIR_UNSPECIFIED);
-    State.setWaitingPeriod(REPEAT_RANGE);
+    State.setAdaptiveRange(REPEAT_MIN, REPEAT_RANGE);
+    State.setRepeatFactor(REPEAT_FACTOR);
 
     Rgb.setup();
     Rgb.pulse(RGBLED_GREEN, 1); // indicate system start finished
@@ -68,12 +152,27 @@ void print() {
     Serial.print(", max_steps: "); Serial.print(max_steps);
     Serial.print(", call_gap: "); Serial.print(Motor.getCallGap());
     Serial.print(", step_gap: "); Serial.print(Motor.getStepGap());
+    Serial.print(", late_avg: "); Serial.print(Motor.getLateMean());
+    Serial.print(", late_max: "); Serial.print(Motor.getLateMax());
+#ifdef STEPPER_HISTOGRAM
+    Histogram step_err = Motor.getStepHistogram();
+    Serial.print(", err_p50: "); Serial.print(step_err.percentile(50));
+    Serial.print(", err_p99: "); Serial.print(step_err.percentile(99));
+#endif
 
     Serial.print(", max_lt: "); Serial.print(Mx.maxLoopTime());
     Serial.print(", avg_lt: "); Serial.print(Mx.avgLoopTime());
+#ifdef METRICS_HISTOGRAM
+    Serial.print(", p50_lt: "); Serial.print(Mx.p50LoopTime());
+    Serial.print(", p99_lt: "); Serial.print(Mx.p99LoopTime());
+#endif
     Serial.print(", rpm: ");    Serial.print(Motor.getRPM());
+    if (Motor.getThrottling()) Serial.print(" (throttled)");
     Serial.print(", dir: ");    Serial.print(Motor.dirName());
     Serial.print(", phase: ");  Serial.print(Motor.getPhase());
+    Serial.print(", power: ");  Serial.print(Motor.powerName());
+    Serial.print(", seq: ");    Serial.print(Motor.sequenceName());
+    Serial.print(", queue: ");  Serial.print(Motor.queueDepth());
 
     Serial.println();
 }
@@ -85,6 +184,83 @@ void print(const char *text) {
     print();
 }
 
+// dump prints the collected histograms.
+void dump() {
+    PROFILER_REPORT(prof_names);
+    Mx.dump();
+#ifdef STEPPER_HISTOGRAM
+    Motor.getStepHistogram().dump("step_err");
+#endif
+}
+
+// report reports the status with the given TM_MSG_* message.
+// With STEPPER_TELEMETRY, it sends a binary status frame (see extras/telemetry).
+void report(uint8_t msg) {
+#ifdef STEPPER_TELEMETRY
+    Tm.begin(TELEMETRY_STATUS);
+    Tm.putUnsigned(msg);
+    Tm.putUnsigned(State.signal());
+    Tm.putUnsigned(State.state());
+    Tm.putUnsigned(State.receiveGap());
+    Tm.putSigned(steps);
+    Tm.putSigned(max_steps);
+    Tm.putUnsigned(Motor.getCallGap());
+    Tm.putUnsigned(Motor.getStepGap());
+    Tm.putUnsigned(Motor.getLateMean());
+    Tm.putUnsigned(Motor.getLateMax());
+#ifdef STEPPER_HISTOGRAM
+    Histogram step_err = Motor.getStepHistogram();
+    Tm.putUnsigned(step_err.percentile(50));
+    Tm.putUnsigned(step_err.percentile(99));
+#else
+    Tm.putUnsigned(0);
+    Tm.putUnsigned(0);
+#endif
+    Tm.putUnsigned(Mx.maxLoopTime());
+    Tm.putUnsigned(Mx.avgLoopTime());
+#ifdef METRICS_HISTOGRAM
+    Tm.putUnsigned(Mx.p50LoopTime());
+    Tm.putUnsigned(Mx.p99LoopTime());
+#else
+    Tm.putUnsigned(0);
+    Tm.putUnsigned(0);
+#endif
+    Tm.putUnsigned(Motor.getRPM());
+    Tm.putUnsigned(Motor.getThrottling());
+    Tm.putUnsigned(Motor.getDir());
+    Tm.putUnsigned(Motor.getPhase());
+    Tm.putUnsigned(Motor.getPowerState());
+    Tm.putUnsigned(Motor.getSequence());
+    Tm.putUnsigned(Motor.queueDepth());
+    Tm.send();
+#else
+    print(telemetryMessage(msg));
+#endif
+}
+
+// drainLog sends pending log records as long as the Serial TX buffer has room,
+// so that draining never blocks the loop.
+void drainLog() {
+    LogRecord r;
+    while (Serial.availableForWrite() >= LOG_LINE_MAX && Log.pop(r)) {
+        Log.addDropped(LOG_DROPPED);  // report drops once the pop made room for the record
+#ifdef STEPPER_TELEMETRY
+        Tm.begin(TELEMETRY_LOG);
+        Tm.putUnsigned(r.id);
+        Tm.putUnsigned(r.time);
+        Tm.putSigned(r.a);
+        Tm.putSigned(r.b);
+        Tm.send();
+#else
+        Serial.print("log: ");
+        Serial.print(log_names[r.id]);
+        Serial.print(", t: "); Serial.print(r.time);
+        Serial.print(", a: "); Serial.print(r.a);
+        Serial.print(", b: "); Serial.println(r.b);
+#endif
+    }
+}
+
 // stops the motor and returns the moved steps from the last movement.
 int stop() {
     if (Motor.getActive()) {
@@ -100,20 +276,48 @@ int stop() {
 
 void step() {
     max_steps = max(steps, max_steps);
+    if (Motor.getTargetMode()) {
+        // keep steps buffered for the timer or profile, so the motor never waits for the loop
+        // and the profile does not start decelerating while the key is still pressed
+        if (steps > 0 && labs(Motor.distanceToGo()) <= Motor.getRampSteps() + 1) {
+            Motor.move(Motor.getDir() == DIR_CW? 1 : -1);
+            moved_steps++;
+            steps--;
+        }
+        Motor.step();  // advances the profile (no-op in timer mode)
+        return;
+    }
+    if (!Motor.queueDone()) {
+        Motor.step();  // finish queued moves first, their steps were counted by queue()
+        return;
+    }
     if (steps > 0) {
         if(Motor.step()) {
             moved_steps++;
             steps--;
         }
+    } else {
+        Motor.pause();  // waiting for the next key repeat, this is no step delay
     }
 }
 
 void idle() { State.setIdle(); }
 
+// queue queues a fixed number of steps in the current direction.
+void queue(int num_steps) {
+    if (Motor.queueMove(num_steps, Motor.getDir())) moved_steps += num_steps;
+    else report(TM_MSG_QUEUE_FULL);
+}
+
 void reset() {
-    print("reset");
+    report(TM_MSG_RESET);
     stop();
     Mx.reset();
+    PROFILER_RESET();
+#ifdef STEPPER_HISTOGRAM
+    Motor.resetStepHistogram();
+#endif
+    Motor.resetClockStats();
     steps = 0;
     max_steps = 0;
     last_moved_steps = 0;
@@ -129,25 +333,24 @@ void run(int command) {
     case FDIR_DOWN: Motor.decRPM(); break;
 
     // function keys
-    case FDIR_A: print("status");          break;
-    case FDIR_B: print("status");          break;
-    case FDIR_C: reset(); print("status"); break;
-    case FDIR_X: stop();  print("stop");   break;
-
-    // fixed step movement
-    case FDIR_1: moved_steps += Motor.turn(1); break;
-    case FDIR_2: moved_steps += Motor.turn(2); break;
-    case FDIR_3: moved_steps += Motor.turn(3); break;
-    case FDIR_4: moved_steps += Motor.turn(4); break;
-    case FDIR_5: moved_steps += Motor.turn(5); break;
-    case FDIR_6: moved_steps += Motor.turn(6); break;
-    case FDIR_7: moved_steps += Motor.turn(7); break;
-    case FDIR_8: moved_steps += Motor.turn(8); break;
-    case FDIR_9: moved_steps += Motor.turn(9); break;
+    case FDIR_A: report(TM_MSG_STATUS);          break;
+    case FDIR_B: report(TM_MSG_STATUS); dump();  break;
+    case FDIR_C: reset(); report(TM_MSG_STATUS); break;
+    case FDIR_X: stop();  report(TM_MSG_STOP);   break;
+
+    // fixed step movement (queued, stepped in the background while the loop continues)
+    case FDIR_1: queue(1); break;
+    case FDIR_2: queue(2); break;
+    case FDIR_3: queue(3); break;
+    case FDIR_4: queue(4); break;
+    case FDIR_5: queue(5); break;
+    case FDIR_6: queue(6); break;
+    case FDIR_7: queue(7); break;
+    case FDIR_8: queue(8); break;
+    case FDIR_9: queue(9); break;
 
     default:
-        Serial.print("invalid command: ");
-        Serial.println(command);
+        Log.add(LOG_INVALID_COMMAND, command);
         break;
     }
 }
@@ -158,25 +361,35 @@ void loop()
 
     // Advance IRstate
 
-    if (Receiver.decode()) {
-        State.next(Receiver.decodedIRData.command);
-        Receiver.resume();
+    bool decoded;
+    { PROFILER_SECTION(PROF_DECODE); decoded = Receiver.decode(); }
+
+    if (decoded) {
+        { PROFILER_SECTION(PROF_STATE); State.nextAt(Receiver.decodedIRData.command, loop_start); }
+        { PROFILER_SECTION(PROF_RESUME); Receiver.resume(); }
     } else {
-        State.next();
+        PROFILER_SECTION(PROF_STATE);
+        State.nextAt(loop_start);  // reuse the loop timestamp to avoid reading the clock again
     }
 
     int state = State.state();
     int signal = State.signal();
 
+    { PROFILER_SECTION(PROF_POWER); Motor.updatePower(); }  // reduce the coil current while not stepping
+
     // Handle idle state
 
     if (state == SIGSTATE_IDLE) {
-        if (Motor.getActive()) {
-            stop();
+        if (!Motor.queueDone()) {
+            { PROFILER_SECTION(PROF_STEP); Motor.step(); }  // finish queued moves and ramps before stopping
+            Mx.observe(micros() - loop_start);
+        } else if (Motor.getActive()) {
+            { PROFILER_SECTION(PROF_STEP); stop(); }
             Mx.observe(micros() - loop_start);  // record metrics before expensive print
-            print("move finished");             // print status after every finished move
+            report(TM_MSG_MOVE_FINISHED);       // report status after every finished move
         } else {
             Mx.observe(micros() - loop_start);  // record metrics for idle loop
+            drainLog();                         // send deferred logs while idle
         }
         return;
     }
@@ -185,16 +398,19 @@ void loop()
 
     if (steps < 0) {
         // this can happen when steps are modified by custom commands
-        stepper_debug("WARNING: resetting steps after seeing negative steps");
+        stepper_debug(LOG_NEGATIVE_STEPS, steps);
         steps = 0;
     }
 
     int dir;
 
-    switch (signal) {
-    case FDIR_RIGHT: dir = DIR_CW;  Rgb.green(64); break;
-    case FDIR_LEFT:  dir = DIR_CCW; Rgb.red(64);   break;
-    default:         dir = DIR_UNSPECIFIED;        break;
+    {
+        PROFILER_SECTION(PROF_RGB);
+        switch (signal) {
+        case FDIR_RIGHT: dir = DIR_CW;  Rgb.green(64); break;
+        case FDIR_LEFT:  dir = DIR_CCW; Rgb.red(64);   break;
+        default:         dir = DIR_UNSPECIFIED;        break;
+        }
     }
 
     // Process new and pending movement requests depending on the IR state
@@ -202,31 +418,31 @@ void loop()
     if (dir != DIR_UNSPECIFIED) {
         switch (state) {
         case SIGSTATE_ACTIVE_REPEATING: // keep at least one steps queued
-            stepper_debug("repeating");
+            stepper_debug(LOG_REPEATING, steps);
             if (steps == 0) steps = 1;
             break;
         case SIGSTATE_ACTIVE:           // add one step from one key press
             Motor.setDir(dir);
             steps += 1;
-            stepper_debug("active");
+            stepper_debug(LOG_ACTIVE, steps);
             break;
         case SIGSTATE_ACTIVE_WAITING:   // process pending steps (0 or 1)
-            stepper_debug("wait");
+            stepper_debug(LOG_WAIT, steps);
             break;
         case SIGSTATE_IDLE:             // already handled at beginning of loop
             break;
         default:
-            stepper_debug("bad state");
+            stepper_debug(LOG_BAD_STATE, state);
             break;
         }
-        step();
+        { PROFILER_SECTION(PROF_STEP); step(); }
         Mx.observe(micros() - loop_start);
         return;
     }
 
     // Process other controller commands (non-movement commands)
 
-    print("control");
+    Log.add(LOG_CONTROL, signal);  // deferred, control commands may run while moving
     run(signal);
     idle();
 }
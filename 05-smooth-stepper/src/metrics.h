@@ -1,9 +1,16 @@
+// Define METRICS_HISTOGRAM to record a histogram of the loop times for percentile queries.
+#ifdef METRICS_HISTOGRAM
+#include "histogram.h"
+#endif
 
 class LoopMetrics {
 private:
     unsigned long max_loop_time = 0;
     unsigned long sum_loop_time = 0;
     unsigned long num_loops = 0;
+#ifdef METRICS_HISTOGRAM
+    Histogram histogram;
+#endif
 public:
     inline LoopMetrics() {};
     ~LoopMetrics() {};
@@ -11,4 +18,14 @@ public:
     void observe(unsigned long loop_time_ms);
     unsigned long maxLoopTime() { return max_loop_time; };
     unsigned long avgLoopTime() { return num_loops != 0? sum_loop_time/num_loops : max_loop_time; };
+#ifdef METRICS_HISTOGRAM
+    // percentileLoopTime returns the upper bucket limit of the given percentile (0-100) of the loop times.
+    unsigned long percentileLoopTime(uint8_t percent) { return histogram.percentile(percent); };
+    unsigned long p50LoopTime() { return percentileLoopTime(50); };
+    unsigned long p90LoopTime() { return percentileLoopTime(90); };
+    unsigned long p99LoopTime() { return percentileLoopTime(99); };
+    void dump() { histogram.dump("loop_time"); };
+#else
+    void dump() {};
+#endif
 };
@@ -0,0 +1,47 @@
+#include "Arduino.h"
+#include "profiler.h"
+
+#ifdef LOOP_PROFILER
+
+unsigned long Profiler::total_micros[PROFILER_MAX_SECTIONS];
+unsigned long Profiler::max_micros[PROFILER_MAX_SECTIONS];
+unsigned long Profiler::calls[PROFILER_MAX_SECTIONS];
+
+// observe adds the elapsed micros of one pass through a section.
+// Total and calls are halved before the total can overflow, which keeps the mean.
+void Profiler::observe(uint8_t id, unsigned long elapsed) {
+    if (id >= PROFILER_MAX_SECTIONS) return;
+    if (total_micros[id] > 0x7FFFFFFFUL - elapsed) {
+        total_micros[id] >>= 1;
+        calls[id] >>= 1;
+    }
+    total_micros[id] += elapsed;
+    calls[id]++;
+    if (elapsed > max_micros[id]) max_micros[id] = elapsed;
+}
+
+// report prints one line per used section: `prof <name>: calls, total, avg, max`.
+// Sections without one of the count names are printed by ID.
+void Profiler::report(const char *const names[], uint8_t count) {
+    for (uint8_t id = 0; id < PROFILER_MAX_SECTIONS; id++) {
+        if (calls[id] == 0) continue;
+        Serial.print("prof ");
+        if (id < count) Serial.print(names[id]);
+        else            Serial.print(id);
+        Serial.print(": calls: "); Serial.print(calls[id]);
+        Serial.print(", total: "); Serial.print(total_micros[id]);
+        Serial.print(", avg: ");   Serial.print(total_micros[id] / calls[id]);
+        Serial.print(", max: ");   Serial.print(max_micros[id]);
+        Serial.println();
+    }
+}
+
+void Profiler::reset() {
+    for (uint8_t id = 0; id < PROFILER_MAX_SECTIONS; id++) {
+        total_micros[id] = 0;
+        max_micros[id] = 0;
+        calls[id] = 0;
+    }
+}
+
+#endif
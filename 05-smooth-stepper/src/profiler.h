@@ -0,0 +1,47 @@
+#pragma once
+
+// Define LOOP_PROFILER to measure the time spent in named sections of the code.
+// Without LOOP_PROFILER, all PROFILER_* macros compile to nothing.
+//
+// Usage:
+//     #define PROF_DECODE 0                // section IDs from 0 to PROFILER_MAX_SECTIONS - 1
+//     { PROFILER_SECTION(PROF_DECODE); Receiver.decode(); }
+//     PROFILER_REPORT(names);              // prints all sections, names is an array of section names
+
+#define PROFILER_MAX_SECTIONS 8
+
+#ifdef LOOP_PROFILER
+
+// Profiler accumulates the micros, calls, and max micros per section.
+class Profiler {
+private:
+    static unsigned long total_micros[PROFILER_MAX_SECTIONS];
+    static unsigned long max_micros[PROFILER_MAX_SECTIONS];
+    static unsigned long calls[PROFILER_MAX_SECTIONS];
+public:
+    static void observe(uint8_t id, unsigned long elapsed);
+    static void report(const char *const names[], uint8_t count);
+    static void reset();
+};
+
+// ProfilerScope measures the time from its creation to the end of the enclosing scope.
+class ProfilerScope {
+private:
+    uint8_t id;
+    unsigned long start;
+public:
+    inline ProfilerScope(uint8_t id) : id(id), start(micros()) {}
+    inline ~ProfilerScope() { Profiler::observe(id, micros() - start); }
+};
+
+#define PROFILER_SECTION(id)   ProfilerScope profiler_scope_##id(id)
+#define PROFILER_REPORT(names) Profiler::report(names, sizeof(names) / sizeof(names[0]))
+#define PROFILER_RESET()       Profiler::reset()
+
+#else
+
+#define PROFILER_SECTION(id)   void()
+#define PROFILER_REPORT(names) void()
+#define PROFILER_RESET()       void()
+
+#endif
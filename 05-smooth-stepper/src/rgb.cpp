@@ -1,16 +1,22 @@
 #include "Arduino.h"
 #include "rgb.h"
 
+// write sets a pin to the given PWM value, or to the nearest of HIGH and LOW in digital mode.
+void RgbLed::write(int pin, int value) {
+    if (digital) digitalWrite(pin, value >= 128? HIGH : LOW);
+    else         analogWrite(pin, value);
+}
+
 void RgbLed::rgbLow(int red, int green, int blue) {
-    analogWrite(pin_1, 255 - red);
-    analogWrite(pin_2, 255 - green);
-    analogWrite(pin_3, 255 - blue);
+    write(pin_1, 255 - red);
+    write(pin_2, 255 - green);
+    write(pin_3, 255 - blue);
 }
 
 void RgbLed::rgbHigh(int red, int green, int blue) {
-    analogWrite(pin_1, red);
-    analogWrite(pin_2, green);
-    analogWrite(pin_3, blue);
+    write(pin_1, red);
+    write(pin_2, green);
+    write(pin_3, blue);
 }
 
 void RgbLed::setup() {
@@ -12,6 +12,8 @@ private:
     int pin_2;
     int pin_3;
     bool common_anode = true;
+    bool digital = false;  // switch the pins on/off instead of PWM
+    void write(int pin, int value);
     void rgbLow(int red, int green, int blue);
     void rgbHigh(int red, int green, int blue);
 public:
@@ -27,7 +29,15 @@ public:
     }
     ~RgbLed() {}
     void setup();
+    // setDigital switches the LED colors fully on or off via digitalWrite instead of PWM,
+    // e.g., if the PWM timer of the pins is used otherwise.
+    void setDigital(bool enabled) { digital = enabled; }
     void rgb(int red, int green, int blue) {
+        if (digital) {  // any luminance turns the color fully on
+            red = red > 0? 255 : 0;
+            green = green > 0? 255 : 0;
+            blue = blue > 0? 255 : 0;
+        }
         if (common_anode) rgbLow(red, green, blue);
         else              rgbHigh(red, green, blue);
     }
@@ -0,0 +1,34 @@
+#include "Arduino.h"
+#include "telemetry.h"
+
+// begin starts a new record of the given type.
+void TelemetryWriter::begin(uint8_t type) {
+    len = 0;
+    put(type);
+    put(seq);
+}
+
+// putUnsigned appends a varint field.
+void TelemetryWriter::putUnsigned(unsigned long value) {
+    while (value >= 0x80) {
+        put((uint8_t)value | 0x80);
+        value >>= 7;
+    }
+    put((uint8_t)value);
+}
+
+// send adds sync, length, and checksum and writes the frame to the Serial.
+// A status record fits into the Serial TX buffer, so that sending does not block the loop.
+void TelemetryWriter::send() {
+    frame[0] = TELEMETRY_SYNC;
+    frame[1] = len;
+    uint8_t ck_a = 0, ck_b = 0;
+    for (uint8_t i = 1; i < len + 2; i++) {
+        ck_a += frame[i];
+        ck_b += ck_a;
+    }
+    frame[len + 2] = ck_a;
+    frame[len + 3] = ck_b;
+    Serial.write(frame, len + 4);
+    seq++;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+// Binary telemetry frames (shared by the sketch and the host decoder in extras/telemetry).
+//
+// Frame:   SYNC | LEN | TYPE SEQ FIELD... | CK_A CK_B
+//   SYNC   TELEMETRY_SYNC
+//   LEN    number of payload bytes (TYPE, SEQ, and FIELDs)
+//   TYPE   record type, e.g., TELEMETRY_STATUS
+//   SEQ    sequence number, incremented per frame (wraps at 256), reveals lost frames
+//   FIELD  varint, 7 bits per byte, least significant first, high bit set if more bytes follow;
+//          signed fields are zigzag encoded: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+//   CK_A/B 8-bit Fletcher checksum over LEN and payload
+
+#define TELEMETRY_SYNC        0xA5
+#define TELEMETRY_MAX_PAYLOAD 120  // fits a status record with all varints at max size (5 bytes)
+
+#define TELEMETRY_STATUS 1  // status record, fields in the order of the TM_* indices
+#define TELEMETRY_LOG    2  // deferred log record, fields in the order of the TM_LOG_* indices
+
+#define TM_MSG        0     // message, see TM_MSG_*
+#define TM_CMD        1     // last IR command
+#define TM_STATE      2     // signal state
+#define TM_REC_GAP    3     // receive gap
+#define TM_STEPS      4     // pending steps (signed)
+#define TM_MAX_STEPS  5     // max pending steps (signed)
+#define TM_CALL_GAP   6     // step call gap
+#define TM_STEP_GAP   7     // step gap
+#define TM_LATE_AVG   8     // mean step lateness
+#define TM_LATE_MAX   9     // max step lateness
+#define TM_ERR_P50   10     // p50 step interval error (0 without STEPPER_HISTOGRAM)
+#define TM_ERR_P99   11     // p99 step interval error (0 without STEPPER_HISTOGRAM)
+#define TM_MAX_LT    12     // max loop time
+#define TM_AVG_LT    13     // mean loop time
+#define TM_P50_LT    14     // p50 loop time (0 without METRICS_HISTOGRAM)
+#define TM_P99_LT    15     // p99 loop time (0 without METRICS_HISTOGRAM)
+#define TM_RPM       16     // RPM
+#define TM_THROTTLED 17     // 1 if the governor caps the RPM
+#define TM_DIR       18     // direction
+#define TM_PHASE     19     // phase
+#define TM_POWER     20     // power state
+#define TM_SEQUENCE  21     // phase sequence
+#define TM_QUEUE     22     // queued moves
+#define TM_FIELDS    23
+
+#define TM_LOG_ID     0     // log message ID
+#define TM_LOG_TIME   1     // micros when the record was added
+#define TM_LOG_A      2     // first argument (signed)
+#define TM_LOG_B      3     // second argument (signed)
+#define TM_LOG_FIELDS 4
+
+#define TM_MSG_NONE          0
+#define TM_MSG_STATUS        1
+#define TM_MSG_STOP          2
+#define TM_MSG_RESET         3
+#define TM_MSG_CONTROL       4
+#define TM_MSG_MOVE_FINISHED 5
+#define TM_MSG_QUEUE_FULL    6
+
+inline const char* telemetryMessage(uint8_t msg) {
+    switch (msg) {
+    case TM_MSG_NONE:          return "none";
+    case TM_MSG_STATUS:        return "status";
+    case TM_MSG_STOP:          return "stop";
+    case TM_MSG_RESET:         return "reset";
+    case TM_MSG_CONTROL:       return "control";
+    case TM_MSG_MOVE_FINISHED: return "move finished";
+    case TM_MSG_QUEUE_FULL:    return "queue full";
+    default:                   return "unknown";
+    }
+}
+
+// TelemetryWriter encodes one record at a time and sends it as a single frame.
+class TelemetryWriter {
+private:
+    uint8_t frame[TELEMETRY_MAX_PAYLOAD + 4];
+    uint8_t len = 0;                   // payload bytes
+    uint8_t seq = 0;
+    void put(uint8_t b) { if (len < TELEMETRY_MAX_PAYLOAD) frame[2 + len++] = b; }
+public:
+    inline TelemetryWriter() {}
+    ~TelemetryWriter() {}
+    void begin(uint8_t type);
+    void putUnsigned(unsigned long value);
+    void putSigned(long value) { putUnsigned(value < 0? ~((unsigned long)value << 1) : (unsigned long)value << 1); }
+    void send();
+    uint8_t sequence() { return seq; }
+};
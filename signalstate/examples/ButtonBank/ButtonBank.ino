@@ -0,0 +1,76 @@
+/*
+ * ButtonBank.ino
+ *
+ * Demonstrates managing many buttons with a single SigStateBank.
+ *
+ *  This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#include "SignalState.h"
+
+// Our system reads eight buttons, each button is managed as an independent channel.
+#define NUM_BUTTONS 8
+#define IDLE 0
+#define PRESSED 1
+
+// The buttons are connected to the digital pins 2 to 9.
+#define FIRST_PIN 2
+
+// Helper function for less verbose print code.
+#define print(msg, value) Serial.print(msg); Serial.print(value);
+
+// Buttons will manage the signal state of all buttons using one timestamp per loop.
+SigStateBank<NUM_BUTTONS> Buttons;
+
+// inputs holds the raw input signal of each button for the current loop.
+int inputs[NUM_BUTTONS];
+
+void setup() {
+    Serial.begin(9600);
+    // define how the program tells the Buttons that no new signal was received
+    Buttons.setIdleSignal(IDLE);
+    for (uint8_t i = 0; i < NUM_BUTTONS; i++) pinMode(FIRST_PIN + i, INPUT);
+}
+
+void processButton(uint8_t button, int state) {
+    print("button=", button);
+    print(", state=", sigStateName(state));
+    Serial.println();
+}
+
+void loop() {
+    // Read all buttons and update all button states using a single timestamp.
+    for (uint8_t i = 0; i < NUM_BUTTONS; i++) {
+        inputs[i] = digitalRead(FIRST_PIN + i) == HIGH? PRESSED : IDLE;
+    }
+    uint8_t changed = Buttons.next(inputs);
+
+    // Only handle the buttons that actually changed.
+    for (uint8_t i = 0; changed != 0; i++, changed >>= 1) {
+        if (changed & 1) processButton(i, Buttons.state(i));
+    }
+}
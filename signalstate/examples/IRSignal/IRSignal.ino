@@ -41,13 +41,14 @@
 #define IR_INPUT_PIN 7
 #define SYSTEM_LED 13
 
-SigState State;
+// IR commands fit into 8 bits and a 16-bit millisecond clock covers the 200 ms wait period.
+// The wait period and idle signal are compile-time constants, which also define
+// how the program tells the State that no new signal was received.
+SigStateT<uint8_t, uint16_t, 200, CMD_IDLE, millis> State;
 IRrecv Receiver(IR_INPUT_PIN);
 
 void setup() {
     Serial.begin(9600);
-    // define how the program tells the State that no new signal was received
-    State.setIdleSignal(CMD_IDLE);
     Receiver.begin(IR_INPUT_PIN, ENABLE_LED_FEEDBACK, SYSTEM_LED);
 }
 
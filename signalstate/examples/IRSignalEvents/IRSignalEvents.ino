@@ -0,0 +1,73 @@
+/*
+ * IRSignalEvents.ino
+ *
+ * Demonstrates event-driven IR signal handling using the SignalState library.
+ *
+ *  This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#include "SignalState.h"
+#include "IRremote.h"
+
+// our system supports three signals, idle + two key presses (or IR signals)
+#define CMD_IDLE 0
+#define CMD_LEFT 67
+#define CMD_RIGHT 68
+
+#define IR_INPUT_PIN 7
+#define SYSTEM_LED 13
+
+// State calls up to 6 handlers on transitions of a compact 8-bit signal state.
+SigEvents<6, SigStateT<uint8_t, uint16_t, 200, CMD_IDLE, millis>> State;
+IRrecv Receiver(IR_INPUT_PIN);
+
+void stepLeft(uint8_t command)  { /* start moving left */ }
+void stepRight(uint8_t command) { /* start moving right */ }
+void moveLeft(uint8_t command)  { /* keep moving left */ }
+void moveRight(uint8_t command) { /* keep moving right */ }
+void stop(uint8_t command)      { /* stop moving */ }
+
+void setup() {
+    Serial.begin(9600);
+    State.on(CMD_LEFT,  SIGSTATE_ACTIVE,           stepLeft);
+    State.on(CMD_RIGHT, SIGSTATE_ACTIVE,           stepRight);
+    State.on(CMD_LEFT,  SIGSTATE_ACTIVE_REPEATING, moveLeft);
+    State.on(CMD_RIGHT, SIGSTATE_ACTIVE_REPEATING, moveRight);
+    State.on(CMD_LEFT,  SIGSTATE_IDLE,             stop);
+    State.on(CMD_RIGHT, SIGSTATE_IDLE,             stop);
+    Receiver.begin(IR_INPUT_PIN, ENABLE_LED_FEEDBACK, SYSTEM_LED);
+}
+
+void loop() {
+    // The handlers are called by next() on transitions only.
+    if (Receiver.decode()) {
+        State.next(Receiver.decodedIRData.command);
+        Receiver.resume();
+    } else {
+        State.next();
+    }
+}
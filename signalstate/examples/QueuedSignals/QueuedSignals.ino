@@ -0,0 +1,83 @@
+/*
+ * QueuedSignals.ino
+ *
+ * Demonstrates recording signals from interrupts and replaying them in the loop.
+ *
+ *  This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#include "SignalState.h"
+
+// Our system supports three signals, idle + two key presses.
+#define IDLE 0
+#define SIG_A 1
+#define SIG_B 2
+
+// We receive these signals via the two external interrupt pins of the Uno.
+#define PIN_A 2
+#define PIN_B 3
+
+// Helper function for less verbose print code.
+#define print(msg, value) Serial.print(msg); Serial.print(value);
+
+// Queue records the signals from the interrupts, State replays them in the loop.
+SigQueue<16> Queue;
+SigState State;
+
+void onSignalA() { Queue.push(SIG_A); }
+void onSignalB() { Queue.push(SIG_B); }
+
+void setup() {
+    Serial.begin(9600);
+    // define how the program tells the State that no new signal was received
+    State.setIdleSignal(IDLE);
+    pinMode(PIN_A, INPUT);
+    pinMode(PIN_B, INPUT);
+    attachInterrupt(digitalPinToInterrupt(PIN_A), onSignalA, RISING);
+    attachInterrupt(digitalPinToInterrupt(PIN_B), onSignalB, RISING);
+}
+
+void loop() {
+    // Replay the next recorded signal, or check for timeouts if there is none.
+    int state = State.drain(Queue);
+
+    switch (state) {
+    case SIGSTATE_IDLE:             break; // do nothing
+    case SIGSTATE_ACTIVE:           print("new signal=", State.signal()); Serial.println(); break;
+    case SIGSTATE_ACTIVE_WAITING:   break; // wait for next signal
+    case SIGSTATE_ACTIVE_REPEATING: break; // keep going
+    }
+
+    // Slow work does not affect the repeat detection, since signals are recorded with their time.
+    // Only a full queue loses signals, which we report once per lost signal.
+    static uint8_t reported = 0;
+    if (Queue.dropped() != reported) {
+        reported = Queue.dropped();
+        print("dropped signals=", reported);
+        Serial.println();
+    }
+}
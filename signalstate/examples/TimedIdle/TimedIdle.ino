@@ -0,0 +1,66 @@
+/*
+ * TimedIdle.ino
+ *
+ * Demonstrates a timer-driven idle timeout while the loop is busy.
+ *
+ *  This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+// Enable the timer interrupt of SigTimeout before including the library.
+#define SIGSTATE_USE_TIMER
+#include "SignalState.h"
+
+// Our system supports two signals, idle + one key press.
+#define IDLE 0
+#define SIG_A 1
+
+// We read the signal via a digital input pin and show the signal state via the built-in LED.
+#define PIN_A 8
+#define LED 13
+
+// State goes idle from the timer interrupt, even while the loop is busy.
+SigTimeout<> State;
+
+// onIdle is called from the timer interrupt, so it must be short.
+void onIdle(int signal) { digitalWrite(LED, LOW); }
+
+void setup() {
+    Serial.begin(9600);
+    pinMode(PIN_A, INPUT);
+    pinMode(LED, OUTPUT);
+    State.setIdleSignal(IDLE);
+    State.setIdleCallback(onIdle);
+    if (!State.begin()) Serial.println("timer not available, going idle in next() only");
+}
+
+void loop() {
+    if (State.next(digitalRead(PIN_A) == HIGH? SIG_A : IDLE) == SIGSTATE_ACTIVE) {
+        digitalWrite(LED, HIGH);
+        Serial.println("signal received, doing some long work");
+        delay(1000);  // the LED is turned off by the timer 200 ms after the last signal
+    }
+}
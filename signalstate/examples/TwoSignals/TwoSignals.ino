@@ -49,7 +49,12 @@
 #define print(msg, value) Serial.print(msg); Serial.print(value);
 
 // State will manage our signal state for the input signals.
-SigState State;
+// Our signals fit into 8 bits and a 16-bit millisecond clock covers the 200 ms wait period.
+SigStateT<uint8_t, uint16_t, 200, IDLE, millis> State;
+
+// Inputs reads and debounces both pins at once, the first pin produces SIG_A, the second SIG_B.
+const uint8_t pins[] = {PIN_A, PIN_B};
+SigScanner Inputs(pins, 2);
 
 // In this demo we just count single signals and repeated signals to log them.
 unsigned long count_a = 0;
@@ -57,16 +62,12 @@ unsigned long count_b = 0;
 
 void setup() {
     Serial.begin(9600);
-    // define how the program tells the State that no new signal was received
-    State.setIdleSignal(IDLE);
-    pinMode(PIN_A, INPUT);
-    pinMode(PIN_B, INPUT);
+    Inputs.setup();
 }
 
 int readSignal() {
-    if      (digitalRead(PIN_A) == 1) return SIG_A;
-    else if (digitalRead(PIN_B) == 1) return SIG_B;
-    else                              return IDLE;
+    Inputs.scan();                 // debounce both pins, without bounces causing new signals
+    return Inputs.signal(IDLE);    // SIG_A, SIG_B, or IDLE
 }
 
 void processSignal(int signal, bool repeating) {
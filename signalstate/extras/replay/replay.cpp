@@ -0,0 +1,223 @@
+/*
+ * replay.cpp
+ *
+ * Host-native record/replay harness and throughput benchmark for SigState.
+ *
+ * Replays timestamped signal traces through SigState::next against a virtual clock,
+ * checks the expected state sequence, and measures the time per event.
+ *
+ *  This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Arduino.h"
+#include "SignalState.h"
+
+unsigned long virtual_micros = 0;
+int virtual_pins[VIRTUAL_PINS];
+HostSerial Serial;
+
+// The timeline from the SigState.h documentation, one column per quarter wait period.
+#define TIMELINE_INPUT "..X.....X.X.X.....X.Y.X.X..Y.Y...."
+#define TIMELINE_STATE "IIAWWWIIAWRRRRRRIIAWAWAWRRRAWRRRRI"
+#define TIMELINE_STEP  50000L   // micros per column
+#define TIMELINE_WAIT  199999L  // goes idle exactly one wait period after the last signal
+
+#define MAX_LINE 128
+
+// stateCode converts a state to the letter used in traces.
+char stateCode(int state) {
+    switch (state) {
+    case SIGSTATE_IDLE:             return 'I';
+    case SIGSTATE_ACTIVE:           return 'A';
+    case SIGSTATE_ACTIVE_WAITING:   return 'W';
+    case SIGSTATE_ACTIVE_REPEATING: return 'R';
+    default:                        return '?';
+    }
+}
+
+// timelineSignal converts a timeline character to a signal code (0=idle).
+int timelineSignal(char c) { return c == '.' ? 0 : c; }
+
+// replay replays a trace file and returns the number of mismatched states, or -1 on errors.
+long replay(const char *path, bool verbose) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "ERROR: cannot open trace file: %s\n", path);
+        return -1;
+    }
+
+    SigState State;
+    SigAdaptive<> Adaptive;
+    bool adaptive = false;  // replay through Adaptive instead of State
+    char line[MAX_LINE];
+    long events = 0, mismatches = 0, line_num = 0;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        line_num++;
+        char *text = line + strspn(line, " \t");
+        if (*text == '#' || *text == '\n' || *text == '\0') continue;
+
+        unsigned long time, wait, min_wait, max_wait;
+        int signal, factor;
+        char expected = '-';
+        if (sscanf(text, "wait %lu", &wait) == 1) {
+            State.setWaitingPeriod(wait);
+            Adaptive.setWaitingPeriod(wait);
+            continue;
+        } else if (sscanf(text, "idle %d", &signal) == 1) {
+            State.setIdleSignal(signal); State.setIdle();
+            Adaptive.setIdleSignal(signal); Adaptive.setIdle();
+            continue;
+        } else if (sscanf(text, "adaptive %lu %lu %d", &min_wait, &max_wait, &factor) == 3) {
+            Adaptive.setAdaptiveRange(min_wait, max_wait);
+            Adaptive.setRepeatFactor(factor);
+            adaptive = true;
+            continue;
+        } else if (sscanf(text, "%lu %d %c", &time, &signal, &expected) < 2) {
+            fprintf(stderr, "ERROR: %s:%ld: invalid line: %s", path, line_num, text);
+            fclose(f);
+            return -1;
+        }
+
+        virtual_micros = time;
+        char actual = stateCode(adaptive? Adaptive.next(signal) : State.next(signal));
+        events++;
+        if (expected != '-' && expected != actual) {
+            mismatches++;
+            printf("%s:%ld: time=%lu signal=%d expected=%c actual=%c\n", path, line_num, time, signal, expected, actual);
+        } else if (verbose) {
+            printf("%s:%ld: time=%lu signal=%d state=%c\n", path, line_num, time, signal, actual);
+        }
+    }
+    fclose(f);
+
+    printf("%s: %ld events, %ld mismatches\n", path, events, mismatches);
+    return mismatches;
+}
+
+// generate prints the timeline as trace with the given number of repetitions.
+void generate(long repetitions) {
+    long columns = strlen(TIMELINE_INPUT);
+    printf("# generated timeline, %ld repetitions\n", repetitions);
+    printf("wait %ld\nidle 0\n", TIMELINE_WAIT);
+    for (long r = 0; r < repetitions; r++) {
+        for (long i = 0; i < columns; i++) {
+            unsigned long time = 1000000L + (r * columns + i) * TIMELINE_STEP;
+            printf("%lu %d %c\n", time, timelineSignal(TIMELINE_INPUT[i]), TIMELINE_STATE[i]);
+        }
+    }
+}
+
+// elapsedNanos returns the nanoseconds between two timestamps.
+double elapsedNanos(const struct timespec &start, const struct timespec &end) {
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+// bench replays the timeline for the given number of events through the given state
+// and returns the number of mismatched states. The expected states are checked on the
+// first repetition only, so that the measured time is dominated by SigState::next.
+template <class State>
+long bench(const char *name, State &state, long events) {
+    const long columns = strlen(TIMELINE_INPUT);
+    int signals[sizeof(TIMELINE_INPUT)];
+    for (long i = 0; i < columns; i++) signals[i] = timelineSignal(TIMELINE_INPUT[i]);
+
+    long mismatches = 0;
+    unsigned long time = 1000000L;
+    for (long i = 0; i < columns; i++, time += TIMELINE_STEP) {
+        virtual_micros = time;
+        if (stateCode(state.next(signals[i])) != TIMELINE_STATE[i]) mismatches++;
+    }
+
+    struct timespec start, end;
+    long checksum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long n = 0, i = 0; n < events; n++, time += TIMELINE_STEP) {
+        virtual_micros = time;
+        checksum += state.next(signals[i]);
+        if (++i == columns) i = 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double nanos = elapsedNanos(start, end);
+    printf("%-40s %10ld events %8.2f ns/event (checksum=%ld, mismatches=%ld)\n",
+           name, events, nanos / events, checksum, mismatches);
+    return mismatches;
+}
+
+void usage() {
+    printf("Usage: replay [-v] [-b EVENTS] [-g REPETITIONS] [TRACE...]\n"
+           "\n"
+           "    TRACE           replay trace file and check the expected states\n"
+           "    -v              print every replayed event\n"
+           "    -b EVENTS       benchmark SigState::next with EVENTS generated events\n"
+           "    -g REPETITIONS  print the generated timeline trace and exit\n"
+           "\n"
+           "Trace format, one entry per line:\n"
+           "    # comment\n"
+           "    wait <micros>                            set the wait period\n"
+           "    idle <signal>                            set the idle signal\n"
+           "    adaptive <min> <max> <factor>            replay via SigAdaptive with the given range and factor\n"
+           "    <micros> <signal> [<expected state>]     replay signal at time (states: I, A, W, R)\n");
+}
+
+int main(int argc, char **argv) {
+    bool verbose = false;
+    long bench_events = 0;
+    long failures = 0;
+    int traces = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if      (strcmp(argv[i], "-h") == 0)               { usage(); return 0; }
+        else if (strcmp(argv[i], "-v") == 0)               { verbose = true; }
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) { bench_events = atol(argv[++i]); }
+        else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) { generate(atol(argv[++i])); return 0; }
+        else {
+            long mismatches = replay(argv[i], verbose);
+            failures += mismatches != 0;
+            traces++;
+        }
+    }
+
+    if (bench_events > 0) {
+        SigState State;
+        State.setWaitingPeriod(TIMELINE_WAIT);
+        failures += bench("SigState", State, bench_events) != 0;
+
+        SigStateT<uint8_t, uint32_t, TIMELINE_WAIT, 0> Narrow;
+        failures += bench("SigStateT<uint8_t, uint32_t, WAIT, 0>", Narrow, bench_events) != 0;
+    } else if (traces == 0) {
+        usage();
+        return 1;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file SigAdaptive.cpp.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigAdaptive_cpp_h
+#define SigAdaptive_cpp_h
+
+#include "SigAdaptive.h"
+
+template <class StateT>
+void SigAdaptive<StateT>::setAdaptiveRange(TimeT min_wait, TimeT max_wait) {
+    min_period = min_wait;
+    max_period = max(min_wait, max_wait);
+    StateT::setWaitingPeriod(max_period);
+}
+
+template <class StateT>
+int SigAdaptive<StateT>::nextAt(SignalT input_signal, TimeT now) {
+    if (input_signal == StateT::idleSignal()) return nextAt(now);
+
+    TimeT gap = (TimeT)(now - last_time);
+    last_time = now;
+    bool repeating = StateT::state() == SIGSTATE_ACTIVE_REPEATING;
+    int state = StateT::nextAt(input_signal, now);
+
+    if (state == SIGSTATE_ACTIVE) {
+        StateT::setWaitingPeriod(max_period);      // always detect the first repeat of a new signal
+        return state;
+    }
+    // The gap between a new signal and its first repeat is not the repeat rate, e.g., NEC
+    // remotes send the first repeat ~40 ms after the end of the full frame, but all other
+    // repeats every 108 ms. Keep the max period until the second repeat.
+    if (!repeating) return state;
+
+    if (repeat_rate == 0) repeat_rate = gap;       // first observation
+    else repeat_rate = repeat_rate - (repeat_rate >> 2) + (gap >> 2);  // rate += (gap - rate) / 4
+
+    unsigned long wait = ((unsigned long)repeat_rate * repeat_factor) >> 4;
+    if      (wait < min_period) wait = min_period;
+    else if (wait > max_period) wait = max_period;
+    StateT::setWaitingPeriod((TimeT)wait);
+    return state;
+}
+
+#endif // SigAdaptive_cpp_h
+#pragma once
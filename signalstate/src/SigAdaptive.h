@@ -0,0 +1,113 @@
+/**
+ * @file SigAdaptive.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigAdaptive_h
+#define SigAdaptive_h
+
+#include "SigState.h"
+
+/*
+SigAdaptive adds an adaptive wait period to a SigState with runtime-configurable wait period.
+
+It measures the time between repeated signals and sets the wait period to a multiple
+of the observed repeat rate, limited by a min and max period. The state then goes idle
+shortly after the last repeat, instead of waiting for a worst-case constant period.
+For instance, with an NEC remote repeating every ~108 ms and the default factor of 1.5,
+the state goes idle ~162 ms after the last repeat.
+
+Each new signal starts with the max period, so that its first repeat is always detected.
+The rate is only learned from the gaps between repeats, not from the gap between the signal
+and its first repeat, which is shorter for NEC remotes. The repeat rate is smoothed over
+the last few repeats using shifts only.
+
+Usage Example:
+
+    SigAdaptive<> State;
+
+    void setup() {
+        State.setAdaptiveRange(50000L, 200000L);  // wait between 50 and 200 ms
+        State.setRepeatFactor(24);                // wait 24/16 = 1.5 times the repeat rate
+    }
+
+*/
+template <class StateT = SigState>
+class SigAdaptive : public StateT {
+public:
+    typedef typename StateT::signal_type SignalT;
+    typedef typename StateT::time_type TimeT;
+private:
+    // last_time is the time when the last signal was received.
+    TimeT last_time = 0;
+    // repeat_rate is the smoothed time between repeated signals (0=unknown).
+    TimeT repeat_rate = 0;
+    // min_period is the lower bound of the adaptive wait period.
+    TimeT min_period = 0;
+    // max_period is the upper bound of the adaptive wait period and the initial wait period.
+    TimeT max_period = StateT::repeatRange();
+    // repeat_factor is the multiple of the repeat rate used as wait period, in sixteenths.
+    uint8_t repeat_factor = 24;
+public:
+    inline SigAdaptive() {}
+    ~SigAdaptive() {}
+
+    // next checks the current state and advances it if necessary.
+    int next() { return nextAt(StateT::now()); }
+    // next processes the next input signal and adapts the wait period to the repeat rate.
+    int next(SignalT input_signal) { return nextAt(input_signal, StateT::now()); }
+    // nextAt works like next, but uses the given time instead of reading the clock.
+    int nextAt(TimeT now) { return StateT::nextAt(now); }
+    // nextAt works like next, but uses the given receive time instead of reading the clock.
+    int nextAt(SignalT input_signal, TimeT now);
+
+    // drain processes the oldest queued signal using its recorded receive time,
+    // or checks the current state via next() if the queue is empty.
+    template <class Queue>
+    int drain(Queue &queue) {
+        typename Queue::signal_type input_signal;
+        typename Queue::time_type time;
+        if (queue.pop(input_signal, time)) return nextAt((SignalT)input_signal, (TimeT)time);
+        return next();
+    }
+
+    // repeatRate returns the observed time between repeated signals (0=unknown).
+    TimeT repeatRate() { return repeat_rate; }
+
+    // setAdaptiveRange sets the bounds of the adaptive wait period and resets
+    // the wait period to the max period.
+    void setAdaptiveRange(TimeT min_wait, TimeT max_wait);
+    // setRepeatFactor sets the multiple of the repeat rate used as wait period,
+    // in sixteenths, e.g., 24 for 1.5 times the repeat rate.
+    void setRepeatFactor(uint8_t sixteenths) { repeat_factor = sixteenths; }
+};
+
+#endif // SigAdaptive_h
+#pragma once
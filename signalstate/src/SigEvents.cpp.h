@@ -0,0 +1,78 @@
+/**
+ * @file SigEvents.cpp.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigEvents_cpp_h
+#define SigEvents_cpp_h
+
+#include "SigEvents.h"
+
+template <uint8_t SIZE, class StateT>
+bool SigEvents<SIZE, StateT>::on(SignalT signal, uint8_t state, handler_t handler) {
+    if (num_handlers >= SIZE) return false;
+    handler_signal[num_handlers] = signal;
+    handler_state[num_handlers] = state;
+    handlers[num_handlers] = handler;
+    num_handlers++;
+    return true;
+}
+
+template <uint8_t SIZE, class StateT>
+void SigEvents<SIZE, StateT>::dispatch(SignalT signal) {
+    uint8_t state = StateT::state();
+    for (uint8_t i = 0; i < num_handlers; i++) {
+        if (handler_state[i] == state && handler_signal[i] == signal) {
+            handlers[i](signal);
+            return;
+        }
+    }
+}
+
+template <uint8_t SIZE, class StateT>
+int SigEvents<SIZE, StateT>::nextAt(TimeT now) {
+    uint8_t prev_state = StateT::state();
+    SignalT prev_signal = StateT::signal();
+    int state = StateT::nextAt(now);
+    if (state == prev_state) return state;         // nothing changed, which is the common case
+    dispatch(prev_signal);                         // ACTIVE -> WAITING keeps and IDLE drops the signal
+    return state;
+}
+
+template <uint8_t SIZE, class StateT>
+int SigEvents<SIZE, StateT>::nextAt(SignalT input_signal, TimeT now) {
+    if (input_signal == StateT::idleSignal()) return nextAt(now);
+    int state = StateT::nextAt(input_signal, now);
+    dispatch(input_signal);                        // every received signal is ACTIVE or a repeat
+    return state;
+}
+
+#endif // SigEvents_cpp_h
+#pragma once
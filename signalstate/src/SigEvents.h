@@ -0,0 +1,127 @@
+/**
+ * @file SigEvents.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigEvents_h
+#define SigEvents_h
+
+#include "SigState.h"
+
+/*
+SigEvents adds an event-driven mode to a SigState. Handlers are registered per signal
+and per state in a fixed-size table and next() calls the matching handler only when a
+transition happens. In the idle case, i.e., most of the time, next() only compares the
+previous state to the new state and no handler is called.
+
+Supported events (states) are:
+
+    SIGSTATE_ACTIVE              entered ACTIVE after receiving a new signal
+    SIGSTATE_ACTIVE_WAITING      entered ACTIVE_WAITING after the first new signal
+    SIGSTATE_ACTIVE_REPEATING    received a repeated signal (called for every repeat)
+    SIGSTATE_IDLE                went idle, the handler receives the signal that went idle
+
+Usage Example:
+
+    SigEvents<4> State;
+
+    void startLeft(int signal) { ... }
+    void keepLeft(int signal)  { ... }
+    void stopLeft(int signal)  { ... }
+
+    void setup() {
+        State.on(CMD_LEFT, SIGSTATE_ACTIVE,           startLeft);
+        State.on(CMD_LEFT, SIGSTATE_ACTIVE_REPEATING, keepLeft);
+        State.on(CMD_LEFT, SIGSTATE_IDLE,             stopLeft);
+    }
+
+    void loop() {
+        if (Receiver.decode()) {
+            State.next(Receiver.decodedIRData.command);
+            Receiver.resume();
+        } else {
+            State.next();
+        }
+    }
+
+*/
+template <uint8_t SIZE, class StateT = SigState>
+class SigEvents : public StateT {
+public:
+    typedef typename StateT::signal_type SignalT;
+    typedef typename StateT::time_type TimeT;
+    // handler_t is the type of the event handlers, which receive the signal of the event.
+    typedef void (*handler_t)(SignalT signal);
+private:
+    // handler_signal is the signal code of each registered handler.
+    SignalT handler_signal[SIZE];
+    // handler_state is the state (event) of each registered handler.
+    uint8_t handler_state[SIZE];
+    // handlers holds the registered handler functions.
+    handler_t handlers[SIZE];
+    // num_handlers is the number of registered handlers.
+    uint8_t num_handlers = 0;
+
+    // dispatch calls the handler matching the current state and the given signal.
+    void dispatch(SignalT signal);
+public:
+    inline SigEvents() {}
+    ~SigEvents() {}
+
+    // on registers a handler for the given signal and state (event).
+    // It returns false if the handler table is full.
+    bool on(SignalT signal, uint8_t state, handler_t handler);
+    // clear removes all registered handlers.
+    void clear() { num_handlers = 0; }
+    // handlerCount returns the number of registered handlers.
+    uint8_t handlerCount() { return num_handlers; }
+
+    // next checks the current state, advances it if necessary, and dispatches transitions.
+    int next() { return nextAt(StateT::now()); }
+    // next processes the next input signal and dispatches the resulting event.
+    int next(SignalT input_signal) { return nextAt(input_signal, StateT::now()); }
+    // nextAt works like next, but uses the given time instead of reading the clock.
+    int nextAt(TimeT now);
+    // nextAt works like next, but uses the given receive time instead of reading the clock.
+    int nextAt(SignalT input_signal, TimeT now);
+
+    // drain processes the oldest queued signal and dispatches the resulting event,
+    // or checks the current state via next() if the queue is empty.
+    template <class Queue>
+    int drain(Queue &queue) {
+        typename Queue::signal_type input_signal;
+        typename Queue::time_type time;
+        if (queue.pop(input_signal, time)) return nextAt((SignalT)input_signal, (TimeT)time);
+        return next();
+    }
+};
+
+#endif // SigEvents_h
+#pragma once
@@ -0,0 +1,77 @@
+/**
+ * @file SigGestures.cpp.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigGestures_cpp_h
+#define SigGestures_cpp_h
+
+#include "SigGestures.h"
+
+template <class StateT>
+void SigGestures<StateT>::checkLongPress(TimeT hold) {
+    if (last_gesture == SIGGESTURE_NONE && long_press_period != 0 && hold >= long_press_period) {
+        last_gesture = SIGGESTURE_LONG_PRESS;
+    }
+}
+
+template <class StateT>
+int SigGestures<StateT>::nextAt(TimeT now) {
+    int state = StateT::nextAt(now);
+    if (state == SIGSTATE_IDLE) last_gesture = SIGGESTURE_NONE;  // gestures end with the active signal
+    return state;
+}
+
+template <class StateT>
+int SigGestures<StateT>::nextAt(SignalT input_signal, TimeT now) {
+    if (input_signal == StateT::idleSignal()) return nextAt(now);
+
+    int state = StateT::nextAt(input_signal, now);
+    if (state == SIGSTATE_ACTIVE) {
+        TimeT tap_gap = (TimeT)(now - press_start);
+        if (input_signal == press_signal && double_tap_period != 0 && tap_gap < double_tap_period) {
+            last_gesture = SIGGESTURE_DOUBLE_TAP;  // second start of the same signal in time
+        } else {
+            last_gesture = SIGGESTURE_NONE;
+        }
+        press_signal = input_signal;
+        press_start = now;
+        hold_duration = 0;
+        repeat_count = 0;
+    } else {                                       // SIGSTATE_ACTIVE_REPEATING
+        hold_duration = (TimeT)(now - press_start);
+        if (repeat_count != 0xFFFF) repeat_count++;
+        checkLongPress(hold_duration);
+    }
+    return state;
+}
+
+#endif // SigGestures_cpp_h
+#pragma once
@@ -0,0 +1,145 @@
+/**
+ * @file SigGestures.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigGestures_h
+#define SigGestures_h
+
+#include "SigState.h"
+
+#define SIGGESTURE_NONE 0
+#define SIGGESTURE_LONG_PRESS 1
+#define SIGGESTURE_DOUBLE_TAP 2
+
+inline const char* sigGestureName(int gesture) {
+    switch (gesture) {
+    case SIGGESTURE_NONE:       return "SIGGESTURE_NONE";
+    case SIGGESTURE_LONG_PRESS: return "SIGGESTURE_LONG_PRESS";
+    case SIGGESTURE_DOUBLE_TAP: return "SIGGESTURE_DOUBLE_TAP";
+    default:                    return "UNKNOWN";
+    }
+}
+
+/*
+SigGestures adds gesture detection to a SigState. The following gestures are supported.
+
+    SIGGESTURE_NONE          no gesture detected (yet)
+    SIGGESTURE_LONG_PRESS    the active signal was held for at least the long-press period
+    SIGGESTURE_DOUBLE_TAP    the active signal was started twice within the double-tap period
+
+The gesture is kept until the state goes idle. A new signal always starts without gesture,
+unless it is the second tap of a double tap. While a signal is active, repeatCount() and
+holdDuration() report the number of repeats and the time between the first and the latest
+received signal, without any extra bookkeeping in the application. Both values are kept
+after going idle, until the next press starts.
+
+Note that a second press of the same signal within the wait period is a repeat, not a tap.
+The double-tap period must therefore be longer than the wait period plus the tap duration.
+
+Usage Example:
+
+    SigGestures<> State;
+
+    void setup() {
+        State.setLongPressPeriod(1000000L);  // 1 s
+        State.setDoubleTapPeriod(600000L);   // 600 ms
+    }
+
+    void loop() {
+        State.next(readSignal());
+        if (State.gesture() == SIGGESTURE_LONG_PRESS) goFaster(State.holdDuration());
+    }
+
+*/
+template <class StateT = SigState>
+class SigGestures : public StateT {
+public:
+    typedef typename StateT::signal_type SignalT;
+    typedef typename StateT::time_type TimeT;
+private:
+    // press_signal is the signal of the last press, kept after going idle to detect double taps.
+    SignalT press_signal = StateT::idleSignal();
+    // press_start is the time when the last press started (the last ACTIVE state).
+    TimeT press_start = 0;
+    // hold_duration is the time between the start of the last press and its latest repeat.
+    TimeT hold_duration = 0;
+    // long_press_period is the hold duration after which a press is a long press (0=disabled).
+    TimeT long_press_period = 0;
+    // double_tap_period is the max duration between two presses of a double tap (0=disabled).
+    TimeT double_tap_period = 0;
+    // repeat_count is the number of repeats of the active signal (saturates at 65535).
+    uint16_t repeat_count = 0;
+    // last_gesture is the current gesture of the active signal.
+    uint8_t last_gesture = SIGGESTURE_NONE;
+
+    // checkLongPress upgrades the gesture to a long press if the press was held long enough.
+    // A press is held as long as repeated signals are received.
+    void checkLongPress(TimeT hold);
+public:
+    inline SigGestures() {}
+    ~SigGestures() {}
+
+    // next checks the current state and gesture and advances them if necessary.
+    int next() { return nextAt(StateT::now()); }
+    // next processes the next input signal and updates state and gesture accordingly.
+    int next(SignalT input_signal) { return nextAt(input_signal, StateT::now()); }
+    // nextAt works like next, but uses the given time instead of reading the clock.
+    int nextAt(TimeT now);
+    // nextAt works like next, but uses the given receive time instead of reading the clock.
+    int nextAt(SignalT input_signal, TimeT now);
+
+    // drain processes the oldest queued signal using its recorded receive time,
+    // or checks the current state via next() if the queue is empty.
+    template <class Queue>
+    int drain(Queue &queue) {
+        typename Queue::signal_type input_signal;
+        typename Queue::time_type time;
+        if (queue.pop(input_signal, time)) return nextAt((SignalT)input_signal, (TimeT)time);
+        return next();
+    }
+
+    // gesture returns the current gesture of the active signal.
+    int gesture() { return last_gesture; }
+    // gestureName returns the name of the current gesture.
+    const char* gestureName() { return sigGestureName(last_gesture); }
+    // repeatCount returns the number of repeats of the active signal.
+    uint16_t repeatCount() { return repeat_count; }
+    // holdDuration returns the time between the first and the latest signal of the active press.
+    TimeT holdDuration() { return hold_duration; }
+
+    // setLongPressPeriod sets the hold duration after which a press is a long press (0=disabled).
+    void setLongPressPeriod(TimeT period) { long_press_period = period; }
+    // setDoubleTapPeriod sets the max duration between the starts of two taps (0=disabled).
+    void setDoubleTapPeriod(TimeT period) { double_tap_period = period; }
+};
+
+#endif // SigGestures_h
+#pragma once
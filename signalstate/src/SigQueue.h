@@ -0,0 +1,128 @@
+/**
+ * @file SigQueue.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigQueue_h
+#define SigQueue_h
+
+#include "Arduino.h"
+
+// SIGQUEUE_BARRIER prevents the compiler from reordering memory accesses across it,
+// so that queue entries are always written before they are published.
+#define SIGQUEUE_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/*
+SigQueue is a lock-free single-producer/single-consumer ring buffer of timestamped signals.
+
+The producer is usually an interrupt service routine (ISR) that records signals as they
+arrive, the consumer is the main loop that replays them via SigState::drain. The recorded
+timestamps keep the repeat detection of the SigState correct even if the loop is blocked
+for some time. SIZE must be a power of two between 2 and 128. SignalT, TimeT, and Clock
+should match the types and clock of the consuming SigStateT.
+
+Usage Example:
+
+    SigQueue<16> Queue;
+    SigState State;
+
+    void onKeyPress() { Queue.push(SIG_A); }  // ISR: only stores signal and time
+
+    void setup() {
+        attachInterrupt(digitalPinToInterrupt(2), onKeyPress, RISING);
+    }
+
+    void loop() {
+        State.drain(Queue);                    // replaces State.next() and State.next(signal)
+    }
+
+*/
+template <uint8_t SIZE, typename SignalT = int, typename TimeT = unsigned long, unsigned long (*Clock)() = micros>
+class SigQueue {
+public:
+    typedef SignalT signal_type;
+    typedef TimeT time_type;
+private:
+    // signals holds the queued signal codes.
+    SignalT signals[SIZE];
+    // times holds the receive time in clock ticks of the queued signals.
+    TimeT times[SIZE];
+    // head is the free-running write index, only modified by the producer.
+    volatile uint8_t head = 0;
+    // tail is the free-running read index, only modified by the consumer.
+    volatile uint8_t tail = 0;
+    // dropped counts the signals that could not be queued because the queue was full.
+    volatile uint8_t dropped_signals = 0;
+public:
+    inline SigQueue() { static_assert(SIZE >= 2 && SIZE <= 128 && (SIZE & (SIZE - 1)) == 0, "SigQueue SIZE must be a power of two between 2 and 128"); }
+    ~SigQueue() {}
+
+    // push stores a signal and its receive time and returns false if the queue is full.
+    // It must only be called by the producer, e.g., from an ISR.
+    bool push(SignalT signal, TimeT time) {
+        uint8_t h = head;
+        if ((uint8_t)(h - tail) >= SIZE) {
+            if (dropped_signals != 0xFF) dropped_signals++;
+            return false;
+        }
+        signals[h & (SIZE - 1)] = signal;
+        times[h & (SIZE - 1)] = time;
+        SIGQUEUE_BARRIER();                 // publish the entry only after it was written
+        head = h + 1;
+        return true;
+    }
+    // push stores a signal using the current time as receive time.
+    bool push(SignalT signal) { return push(signal, (TimeT)Clock()); }
+
+    // pop removes the oldest signal and its receive time from the queue.
+    // It returns false if the queue is empty and must only be called by the consumer.
+    bool pop(SignalT &signal, TimeT &time) {
+        uint8_t t = tail;
+        if (t == head) return false;
+        SIGQUEUE_BARRIER();                 // read the entry only after it was published
+        signal = signals[t & (SIZE - 1)];
+        time = times[t & (SIZE - 1)];
+        SIGQUEUE_BARRIER();                 // release the slot only after it was read
+        tail = t + 1;
+        return true;
+    }
+
+    // size returns the number of queued signals.
+    uint8_t size() { return head - tail; }
+    // empty returns true if no signals are queued.
+    bool empty() { return head == tail; }
+    // capacity returns the maximum number of queued signals.
+    uint8_t capacity() { return SIZE; }
+    // dropped returns the number of signals lost due to a full queue (saturates at 255).
+    uint8_t dropped() { return dropped_signals; }
+};
+
+#endif // SigQueue_h
+#pragma once
@@ -0,0 +1,115 @@
+/**
+ * @file SigScanner.cpp.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigScanner_cpp_h
+#define SigScanner_cpp_h
+
+#include "SigScanner.h"
+
+SigScanner::SigScanner(const uint8_t *pins, uint8_t num_pins, bool active_low) {
+    this->num_pins = min(num_pins, SIGSCANNER_MAX_PINS);
+    this->active_low = active_low;
+    for (uint8_t i = 0; i < this->num_pins; i++) pin_list[i] = pins[i];
+
+#if defined(__AVR__)
+    // use the port register if all pins share the same port
+    uint8_t port = digitalPinToPort(pin_list[0]);
+    for (uint8_t i = 0; i < this->num_pins; i++) {
+        if (digitalPinToPort(pin_list[i]) != port) return;  // fall back to digitalRead
+        port_mask[i] = digitalPinToBitMask(pin_list[i]);
+    }
+    input_register = portInputRegister(port);
+
+    // use a single shift if the pins are consecutive port bits
+    uint8_t shift = 0;
+    while (shift < 8 && port_mask[0] != (1 << shift)) shift++;
+    for (uint8_t i = 1; i < this->num_pins; i++) {
+        if (port_mask[i] != (port_mask[i - 1] << 1)) return;
+    }
+    port_shift = shift;
+#endif
+}
+
+void SigScanner::setup() {
+    for (uint8_t i = 0; i < num_pins; i++) pinMode(pin_list[i], active_low? INPUT_PULLUP : INPUT);
+}
+
+uint8_t SigScanner::sample() {
+    uint8_t value = 0;
+#if defined(__AVR__)
+    if (input_register != NULL) {
+        uint8_t port = *input_register;                         // read all pins at once
+        if (port_shift != 0xFF) {
+            value = port >> port_shift;
+        } else {
+            for (uint8_t i = 0; i < num_pins; i++) {
+                if (port & port_mask[i]) value |= 1 << i;
+            }
+        }
+    } else
+#endif
+    {
+        for (uint8_t i = 0; i < num_pins; i++) {
+            if (digitalRead(pin_list[i]) == HIGH) value |= 1 << i;
+        }
+    }
+    if (active_low) value = ~value;
+    return value & (uint8_t)((1 << num_pins) - 1);
+}
+
+uint8_t SigScanner::scanAt(unsigned long now) {
+    if (now - last_scan < scan_interval) return 0;
+    last_scan = now;
+    return update();
+}
+
+uint8_t SigScanner::update() {
+    uint8_t changed = debounced ^ sample();   // pins differing from the debounced state
+    cnt0 = ~(cnt0 & changed);                 // count up or reset the low counter bits
+    cnt1 = cnt0 ^ (cnt1 & changed);           // count up or reset the high counter bits
+    changed &= cnt0 & cnt1;                   // accept changes after 4 equal samples
+    debounced ^= changed;
+    pressed_edges = debounced & changed;
+    released_edges = ~debounced & changed;
+    return changed;
+}
+
+int SigScanner::signal(int idle_signal) {
+    uint8_t value = debounced;
+    if (value == 0) return idle_signal;
+    int signal = 1;
+    while ((value & 1) == 0) { value >>= 1; signal++; }
+    return signal;
+}
+
+#endif // SigScanner_cpp_h
+#pragma once
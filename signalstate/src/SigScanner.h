@@ -0,0 +1,128 @@
+/**
+ * @file SigScanner.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigScanner_h
+#define SigScanner_h
+
+#include "Arduino.h"
+
+#define SIGSCANNER_MAX_PINS 8
+
+/*
+SigScanner reads and debounces up to 8 digital input pins together.
+
+On AVR boards, pins sharing one port are read with a single port register read instead of
+one digitalRead per pin. All pins are debounced in parallel using a 2-bit vertical counter,
+i.e., a pin must read the same value on 4 consecutive samples before its debounced state
+changes. With the default sample interval of 2 ms, this filters bounces up to 8 ms.
+
+Use signal() to feed the debounced inputs into a SigState. Use more scanners for more pins.
+
+Usage Example:
+
+    const uint8_t pins[] = {8, 9};
+    SigScanner Inputs(pins, 2);
+    SigState State;
+
+    void setup() { Inputs.setup(); }
+
+    void loop() {
+        Inputs.scan();
+        State.next(Inputs.signal(IDLE));  // 1 for pin 8, 2 for pin 9, IDLE if none
+    }
+
+*/
+class SigScanner {
+private:
+    // pin_list holds the scanned pins, in the order of the state bits.
+    uint8_t pin_list[SIGSCANNER_MAX_PINS];
+    // num_pins is the number of scanned pins.
+    uint8_t num_pins;
+    // active_low inverts the pin values, e.g., for buttons using INPUT_PULLUP.
+    bool active_low;
+#if defined(__AVR__)
+    // input_register is the shared port input register of all pins (NULL=pins span ports).
+    volatile uint8_t *input_register = NULL;
+    // port_mask holds the port bit of each pin.
+    uint8_t port_mask[SIGSCANNER_MAX_PINS];
+    // port_shift is the shift of the first pin if all pins are consecutive port bits (0xFF=not consecutive).
+    uint8_t port_shift = 0xFF;
+#endif
+    // cnt0 and cnt1 are the low and high bits of the per-pin vertical sample counters.
+    uint8_t cnt0 = 0xFF;
+    uint8_t cnt1 = 0xFF;
+    // debounced holds the debounced pin states, bit i is the state of pin_list[i].
+    uint8_t debounced = 0;
+    // pressed_edges and released_edges hold the pins that changed on the last sample.
+    uint8_t pressed_edges = 0;
+    uint8_t released_edges = 0;
+    // last_scan is the time in micros of the last sample.
+    unsigned long last_scan = 0;
+    // scan_interval is the time in micros between two samples.
+    unsigned long scan_interval = 2000;
+
+    // sample reads all pins at once and returns their raw state, bit i is the state of pin_list[i].
+    uint8_t sample();
+public:
+    SigScanner(const uint8_t *pins, uint8_t num_pins, bool active_low = false);
+    ~SigScanner() {}
+
+    // setup configures all pins as inputs, using the internal pull-ups for active-low pins.
+    void setup();
+
+    // scan samples and debounces all pins if the sample interval has passed.
+    // It returns a bitmask of the pins whose debounced state changed.
+    uint8_t scan() { return scanAt(micros()); }
+    // scanAt works like scan, but uses the given time in micros instead of reading the clock.
+    uint8_t scanAt(unsigned long now);
+    // update samples and debounces all pins immediately.
+    // It returns a bitmask of the pins whose debounced state changed.
+    uint8_t update();
+
+    // state returns the debounced state of all pins, bit i is the state of pin i.
+    uint8_t state() { return debounced; }
+    // pressed returns the pins that became active on the last sample.
+    uint8_t pressed() { return pressed_edges; }
+    // released returns the pins that became inactive on the last sample.
+    uint8_t released() { return released_edges; }
+    // active returns true if the debounced state of pin i is active.
+    bool active(uint8_t i) { return (debounced >> i) & 1; }
+
+    // signal returns i + 1 for the first active pin i, or the idle_signal if no pin is active.
+    int signal(int idle_signal);
+
+    // setScanInterval sets the time in micros between two samples.
+    void setScanInterval(unsigned long micros) { scan_interval = micros; }
+};
+
+#endif // SigScanner_h
+#pragma once
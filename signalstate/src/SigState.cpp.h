@@ -41,8 +41,9 @@
 #define sigstate_debug(text, value) void();
 #endif
 
-int SigState::next() {
-    if (receiveGap() > wait_period) {
+SIGSTATE_TEMPLATE
+int SIGSTATE_T::nextAt(TimeT now) {
+    if (receiveGap(now) > this->repeatRange()) {
         setIdle();                                 // go idle after some time
     }
     else if (last_state == SIGSTATE_ACTIVE) {
@@ -55,14 +56,19 @@ int SigState::next() {
     return last_state;
 }
 
-int SigState::next(int input_signal) {
+SIGSTATE_TEMPLATE
+int SIGSTATE_T::next(SignalT input_signal) {
     sigstate_debug("cmd: ", input_signal);
-    if(input_signal == idle_signal) return next();
+    return nextAt(input_signal, now());
+}
+
+SIGSTATE_TEMPLATE
+int SIGSTATE_T::nextAt(SignalT input_signal, TimeT now) {
+    if(input_signal == this->idleSignal()) return nextAt(now);
 
-    unsigned long now = micros();
-    unsigned long receive_gap = now - last_receive;
+    TimeT receive_gap = receiveGap(now);
     last_receive = now;
-    if (input_signal == last_signal && receive_gap < wait_period) {
+    if (input_signal == last_signal && receive_gap < this->repeatRange()) {
         last_state = SIGSTATE_ACTIVE_REPEATING;
     } else {
         last_signal = input_signal;
@@ -72,12 +78,13 @@ int SigState::next(int input_signal) {
     return last_state;
 }
 
-void SigState::setIdle() {
-    if (last_signal != idle_signal || last_state != SIGSTATE_IDLE) {
+SIGSTATE_TEMPLATE
+void SIGSTATE_T::setIdle() {
+    if (last_signal != this->idleSignal() || last_state != SIGSTATE_IDLE) {
         sigstate_debug("going idle after signal: ", last_signal);
         sigstate_debug("going idle after state:", last_state);
         last_state = SIGSTATE_IDLE;
-        last_signal = idle_signal;
+        last_signal = this->idleSignal();
     }
 }
 
@@ -34,6 +34,7 @@
 #define SigState_h
 
 #include "Arduino.h"
+#include "SigQueue.h"
 
 #define SIGSTATE_IDLE 0
 #define SIGSTATE_ACTIVE 1
@@ -50,6 +51,47 @@ inline const char* sigStateName(int state) {
     }
 }
 
+// SIGSTATE_TEMPLATE and SIGSTATE_T shorten the member definitions of SigStateT.
+#define SIGSTATE_TEMPLATE template <typename SignalT, typename TimeT, TimeT WaitPeriod, SignalT IdleSignal, unsigned long (*Clock)()>
+#define SIGSTATE_T SigStateT<SignalT, TimeT, WaitPeriod, IdleSignal, Clock>
+
+// SigStateConfig provides the wait period and idle signal of a SigStateT.
+// If WaitPeriod is not 0, both values are compile-time constants and need no RAM.
+template <typename SignalT, typename TimeT, TimeT WaitPeriod, SignalT IdleSignal, bool Runtime = (WaitPeriod == 0)>
+class SigStateConfig {
+public:
+    // repeatRange returns the duration within which matching consecutive signals
+    // are considered as repeated signals.
+    TimeT repeatRange() { return WaitPeriod; }
+    // idleSignal returns the signal code observed by unknown signals.
+    SignalT idleSignal() { return IdleSignal; }
+};
+
+// SigStateConfig with WaitPeriod 0 stores the wait period and idle signal at runtime.
+template <typename SignalT, typename TimeT, TimeT WaitPeriod, SignalT IdleSignal>
+class SigStateConfig<SignalT, TimeT, WaitPeriod, IdleSignal, true> {
+private:
+    // idle_signal is the signal code associated to unknown signals (default=0).
+    // For instance, the IRremote library produces the command code `0` for unknown IR signals.
+    SignalT idle_signal = IdleSignal;
+    // duration in clock ticks until a signal is no longer considered as repeated.
+    // The default is 200 ms: 200000 ticks of the default micros clock for 32-bit TimeT,
+    // 200 ticks for narrow TimeT, which cannot hold 200000 and usually count millis.
+    TimeT wait_period = sizeof(TimeT) >= 4? (TimeT)200000L : (TimeT)200;
+public:
+    // repeatRange returns the duration within which matching consecutive signals
+    // are considered as repeated signals.
+    TimeT repeatRange() { return wait_period; }
+    // idleSignal returns the signal code observed by unknown signals.
+    SignalT idleSignal() { return idle_signal; }
+
+    // setWaitingPeriod sets the duration within which matching consecutive signals
+    // are considered as repeated signals.
+    void setWaitingPeriod(TimeT period) { wait_period = period; }
+    // setIdleSignal sets the signal code observed by unknown signals.
+    void setIdleSignal(SignalT signal) { idle_signal = signal; }
+};
+
 /*
 SigState manages observed signals and keeps track of signal repetitions.
 The following states are supported.
@@ -98,30 +140,67 @@ Example signals and state changes:
           periods)
 
 */
-class SigState {
+/*
+SigStateT is the SigState state machine with configurable storage types.
+
+    SignalT     type of the signal codes, e.g., uint8_t for 8-bit IRremote commands
+    TimeT       type of the timestamps, e.g., uint16_t for a 16-bit millisecond counter
+    WaitPeriod  wait period in clock ticks, 0 selects a runtime-configurable wait period and idle signal
+    IdleSignal  signal code observed by unknown signals (initial value if WaitPeriod is 0)
+    Clock       function providing the current time, e.g., micros or millis
+
+With a non-zero WaitPeriod, the wait period and idle signal are folded into the code as
+immediate values. For instance, the following state needs 4 bytes of RAM instead of 13 (on AVR).
+
+    SigStateT<uint8_t, uint16_t, 200, 0, millis> State;  // 200 ms wait period
+
+Narrow TimeT values wrap around quickly, e.g., a 16-bit millisecond counter after 65 seconds.
+Call next() at least once per wrap-around period to ensure the state goes idle in time.
+*/
+template <typename SignalT = int, typename TimeT = unsigned long, TimeT WaitPeriod = 0, SignalT IdleSignal = 0, unsigned long (*Clock)() = micros>
+class SigStateT : public SigStateConfig<SignalT, TimeT, WaitPeriod, IdleSignal> {
+public:
+    typedef SignalT signal_type;
+    typedef TimeT time_type;
 private:
-    // idle_signal is the signal code associated to unknown signals (default=0).
-    // For instance, the IRremote library produces the command code `0` for unknown IR signals.
-    int idle_signal = 0;
     // last_signal is the last observed or retained signal code
-    int last_signal = 0;
+    SignalT last_signal = IdleSignal;
     // last_state is the current IR state, according to the received signals and timeouts.
-    int last_state = SIGSTATE_IDLE;
-    // last_receive is the time in micros when the last IR signal was received.
-    unsigned long last_receive = 0;
-    // duration in micros until a signal is no longer considered as repeated.
-    unsigned long wait_period = 200000L;
+    uint8_t last_state = SIGSTATE_IDLE;
+    // last_receive is the time in clock ticks when the last IR signal was received.
+    TimeT last_receive = 0;
 public:
-    inline SigState() {}
-    ~SigState() {}
+    inline SigStateT() {}
+    ~SigStateT() {}
+
+    // now returns the current time in clock ticks of the state's clock.
+    static TimeT now() { return (TimeT)Clock(); }
 
     // next checks the current state and advances it if necessary.
-    int next();
+    int next() { return nextAt(now()); }
     // next consumes and processes the next input signal and updates the signal state accordingly.
-    int next(int input_signal);
+    int next(SignalT input_signal);
+
+    // nextAt checks the current state at the given time in clock ticks and advances it if necessary.
+    // It is not an overload of next, since next(now) would be ambiguous with next(input_signal).
+    int nextAt(TimeT now);
+    // nextAt processes an input signal that was received at the given time in clock ticks.
+    int nextAt(SignalT input_signal, TimeT now);
+
+    // drain processes the oldest queued signal using its recorded receive time,
+    // or checks the current state via next() if the queue is empty.
+    // Only one signal is processed per call, so that no state is skipped.
+    // The queue must use the same clock as the state.
+    template <class Queue>
+    int drain(Queue &queue) {
+        typename Queue::signal_type input_signal;
+        typename Queue::time_type time;
+        if (queue.pop(input_signal, time)) return nextAt((SignalT)input_signal, (TimeT)time);
+        return next();
+    }
 
     // signal returns the current active signal according to the current state.
-    int signal() { return last_signal; }
+    SignalT signal() { return last_signal; }
 
     // state returns the current state of the SigState.
     int state() { return last_state; }
@@ -130,20 +209,17 @@ public:
     const char* stateName() { return sigStateName(last_state); }
 
     // receiveGap returns the time since the last IR signal was received.
-    unsigned long receiveGap()  { return micros() - last_receive; }
-    // repeatRange returns the duration within which matching consecutive signals
-    // are considered as repeated signals.
-    unsigned long repeatRange() { return wait_period; }
-
-    // setWaitingPeriod sets the duration within which matching consecutive signals
-    // are considered as repeated signals.
-    void setWaitingPeriod(unsigned long micros) { wait_period = micros; }
-    // setIdleSignal sets the signal code observed by unknown signals.
-    void setIdleSignal(int signal) { idle_signal = signal; }
+    TimeT receiveGap()  { return receiveGap(now()); }
+    // receiveGap returns the time between the last received IR signal and the given time in clock ticks.
+    TimeT receiveGap(TimeT now) { return (TimeT)(now - last_receive); }
 
     // setIdle sets the signal state to idle and resets the last observed signal.
     void setIdle();
 };
 
+// SigState is the general SigState with runtime-configurable wait period and idle signal.
+// It uses int signal codes and unsigned long timestamps in micros.
+typedef SigStateT<> SigState;
+
 #endif // SigState_h
 #pragma once
@@ -0,0 +1,108 @@
+/**
+ * @file SigStateBank.cpp.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigStateBank_cpp_h
+#define SigStateBank_cpp_h
+
+#include "SigStateBank.h"
+
+template <uint8_t CHANNELS>
+bool SigStateBank<CHANNELS>::advance(uint8_t channel, int input_signal, unsigned long now) {
+    uint8_t state = last_state[channel];
+    int signal = last_signal[channel];
+    unsigned long receive_gap = now - last_receive[channel];
+
+    if (input_signal == idle_signal) {
+        if (receive_gap > wait_period) {
+            state = SIGSTATE_IDLE;                  // go idle after some time
+            signal = idle_signal;
+        }
+        else if (state == SIGSTATE_ACTIVE) {
+            state = SIGSTATE_ACTIVE_WAITING;        // wait for repeat after first new signal
+        }
+    } else {
+        last_receive[channel] = now;
+        if (input_signal == signal && receive_gap < wait_period) {
+            state = SIGSTATE_ACTIVE_REPEATING;
+        } else {
+            signal = input_signal;
+            state = SIGSTATE_ACTIVE;
+        }
+    }
+
+    if (state == last_state[channel] && signal == last_signal[channel]) return false;
+    last_state[channel] = state;
+    last_signal[channel] = signal;
+    return true;
+}
+
+template <uint8_t CHANNELS>
+typename SigStateBank<CHANNELS>::mask_t SigStateBank<CHANNELS>::nextAt(unsigned long now) {
+    last_now = now;
+    mask_t changed = 0;
+    mask_t bit = 1;
+    for (uint8_t i = 0; i < CHANNELS; i++, bit <<= 1) {
+        if (advance(i, idle_signal, now)) changed |= bit;
+    }
+    return changed;
+}
+
+template <uint8_t CHANNELS>
+typename SigStateBank<CHANNELS>::mask_t SigStateBank<CHANNELS>::nextAt(const int input_signals[CHANNELS], unsigned long now) {
+    last_now = now;
+    mask_t changed = 0;
+    mask_t bit = 1;
+    for (uint8_t i = 0; i < CHANNELS; i++, bit <<= 1) {
+        if (advance(i, input_signals[i], now)) changed |= bit;
+    }
+    return changed;
+}
+
+template <uint8_t CHANNELS>
+typename SigStateBank<CHANNELS>::mask_t SigStateBank<CHANNELS>::nextAt(uint8_t channel, int input_signal, unsigned long now) {
+    last_now = now;
+    mask_t changed = 0;
+    mask_t bit = 1;
+    for (uint8_t i = 0; i < CHANNELS; i++, bit <<= 1) {
+        if (advance(i, i == channel? input_signal : idle_signal, now)) changed |= bit;
+    }
+    return changed;
+}
+
+template <uint8_t CHANNELS>
+void SigStateBank<CHANNELS>::setIdle(uint8_t channel) {
+    last_state[channel] = SIGSTATE_IDLE;
+    last_signal[channel] = idle_signal;
+}
+
+#endif // SigStateBank_cpp_h
+#pragma once
@@ -0,0 +1,139 @@
+/**
+ * @file SigStateBank.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigStateBank_h
+#define SigStateBank_h
+
+#include "SigState.h"
+
+// sigstate_mask selects the smallest unsigned type that has one bit per channel.
+template <bool Byte, bool Word> struct sigstate_mask       { typedef uint32_t type; };
+template <bool Word>            struct sigstate_mask<true, Word>  { typedef uint8_t  type; };
+template <>                     struct sigstate_mask<false, true> { typedef uint16_t type; };
+
+/*
+SigStateBank manages the signal states of many independent input channels,
+such as a row of buttons, using the same state machine as SigState.
+
+All channels share one wait period and one idle signal, and the channel data is
+stored as struct-of-arrays. Each call to next reads the time base only once and
+advances all channels with the same timestamp. The returned bitmask has a bit
+set for every channel that changed its state or signal, so the loop only needs
+to handle the channels that actually changed.
+
+Usage Example:
+
+    SigStateBank<8> Keys;
+    int inputs[8];
+
+    void loop() {
+        for (uint8_t i = 0; i < 8; i++) inputs[i] = readKey(i);
+        uint8_t changed = Keys.next(inputs);
+        for (uint8_t i = 0; changed != 0; i++, changed >>= 1) {
+            if (changed & 1) handleKey(i, Keys.state(i), Keys.signal(i));
+        }
+    }
+
+*/
+template <uint8_t CHANNELS>
+class SigStateBank {
+public:
+    // mask_t is the type of the changed-channels bitmask (uint8_t, uint16_t, or uint32_t).
+    typedef typename sigstate_mask<CHANNELS <= 8, CHANNELS <= 16>::type mask_t;
+private:
+    // idle_signal is the signal code associated to unknown signals (default=0).
+    int idle_signal = 0;
+    // duration in micros until a signal is no longer considered as repeated.
+    unsigned long wait_period = 200000L;
+    // last_signal is the last observed or retained signal code per channel.
+    int last_signal[CHANNELS] = {};
+    // last_state is the current state per channel.
+    uint8_t last_state[CHANNELS] = {};
+    // last_receive is the time in micros when the last signal was received per channel.
+    unsigned long last_receive[CHANNELS] = {};
+    // last_now is the timestamp of the most recent call to next.
+    unsigned long last_now = 0;
+
+    // advance moves one channel forward to the time `now` and returns true if it changed.
+    bool advance(uint8_t channel, int input_signal, unsigned long now);
+public:
+    inline SigStateBank() { static_assert(CHANNELS > 0 && CHANNELS <= 32, "SigStateBank supports 1 to 32 channels"); }
+    ~SigStateBank() {}
+
+    // next checks the state of all channels and advances them if necessary.
+    // It returns a bitmask of the channels that changed.
+    mask_t next() { return nextAt(micros()); }
+    // next consumes one input signal per channel and updates all channel states.
+    // It returns a bitmask of the channels that changed.
+    mask_t next(const int input_signals[CHANNELS]) { return nextAt(input_signals, micros()); }
+    // next consumes the input signal of a single channel and checks the other channels.
+    // It returns a bitmask of the channels that changed.
+    mask_t next(uint8_t channel, int input_signal) { return nextAt(channel, input_signal, micros()); }
+
+    // nextAt works like next, but uses the given time in micros instead of reading the clock.
+    mask_t nextAt(unsigned long now);
+    // nextAt works like next, but uses the given time in micros instead of reading the clock.
+    mask_t nextAt(const int input_signals[CHANNELS], unsigned long now);
+    // nextAt works like next, but uses the given time in micros instead of reading the clock.
+    mask_t nextAt(uint8_t channel, int input_signal, unsigned long now);
+
+    // channels returns the number of managed channels.
+    uint8_t channels() { return CHANNELS; }
+
+    // signal returns the current active signal of the given channel.
+    int signal(uint8_t channel) { return last_signal[channel]; }
+
+    // state returns the current state of the given channel.
+    int state(uint8_t channel) { return last_state[channel]; }
+
+    // stateName returns the name of the current state of the given channel.
+    const char* stateName(uint8_t channel) { return sigStateName(last_state[channel]); }
+
+    // receiveGap returns the time since the last signal was received on the given channel,
+    // measured at the time of the last call to next.
+    unsigned long receiveGap(uint8_t channel) { return last_now - last_receive[channel]; }
+    // repeatRange returns the duration within which matching consecutive signals
+    // are considered as repeated signals.
+    unsigned long repeatRange() { return wait_period; }
+
+    // setWaitingPeriod sets the duration within which matching consecutive signals
+    // are considered as repeated signals.
+    void setWaitingPeriod(unsigned long micros) { wait_period = micros; }
+    // setIdleSignal sets the signal code observed by unknown signals.
+    void setIdleSignal(int signal) { idle_signal = signal; }
+
+    // setIdle sets the given channel to idle and resets its last observed signal.
+    void setIdle(uint8_t channel);
+};
+
+#endif // SigStateBank_h
+#pragma once
@@ -0,0 +1,109 @@
+/**
+ * @file SigTimeout.cpp.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigTimeout_cpp_h
+#define SigTimeout_cpp_h
+
+#include "SigTimeout.h"
+
+SigTimeoutTick *SigTimeoutTick::first_tick = NULL;
+
+void SigTimeoutTick::tickAll() {
+    for (SigTimeoutTick *t = first_tick; t != NULL; t = t->next_tick) t->tick();
+}
+
+#if defined(__AVR__) && defined(SIGSTATE_USE_TIMER)
+
+bool SigTimeoutTick::attach() {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        // a second attach (e.g., calling begin twice) must not link the tick to itself
+        for (SigTimeoutTick *t = first_tick; t != NULL; t = t->next_tick) if (t == this) return true;
+        next_tick = first_tick;
+        first_tick = this;
+        // The compare-B match happens once per Timer0 cycle (1.024 ms) for any OCR0B value.
+        // OCR0B is not modified, since it sets the PWM duty cycle of analogWrite on pin 5.
+        TIMSK0 |= _BV(OCIE0B);
+    }
+    return true;
+}
+
+ISR(TIMER0_COMPB_vect) {
+    SigTimeoutTick::tickAll();
+}
+
+#else
+
+bool SigTimeoutTick::attach() { return false; }
+
+#endif
+
+template <class StateT>
+void SigTimeout<StateT>::tick() {
+    if (!armed) return;                             // nothing to do while idle
+    TimeT now = StateT::now();
+    if (StateT::receiveGap(now) <= StateT::repeatRange()) return;
+    SignalT signal = StateT::signal();
+    StateT::setIdle();
+    armed = false;
+    if (idle_callback != NULL) idle_callback(signal);
+}
+
+template <class StateT>
+int SigTimeout<StateT>::nextAt(TimeT now) {
+    int state;
+    bool went_idle = false;
+    SignalT signal;
+    SIGTIMEOUT_ATOMIC {
+        signal = StateT::signal();
+        state = StateT::nextAt(now);
+        if (armed && state == SIGSTATE_IDLE) {
+            armed = false;                          // the loop was faster than the timer
+            went_idle = true;
+        }
+    }
+    if (went_idle && idle_callback != NULL) idle_callback(signal);
+    return state;
+}
+
+template <class StateT>
+int SigTimeout<StateT>::nextAt(SignalT input_signal, TimeT now) {
+    if (input_signal == StateT::idleSignal()) return nextAt(now);
+    int state;
+    SIGTIMEOUT_ATOMIC {
+        state = StateT::nextAt(input_signal, now);
+        armed = true;                               // (re)arm the idle deadline
+    }
+    return state;
+}
+
+#endif // SigTimeout_cpp_h
+#pragma once
@@ -0,0 +1,145 @@
+/**
+ * @file SigTimeout.h
+ *
+ * @brief Public API of the Arduino-SignalState library.
+ *
+ * This file is part of Arduino-SignalState https://github.com/ubunatic/arduino/signalstate.
+ *
+ ************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021 Uwe Jugel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SigTimeout_h
+#define SigTimeout_h
+
+#include "SigState.h"
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#define SIGTIMEOUT_ATOMIC ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define SIGTIMEOUT_ATOMIC
+#endif
+
+/*
+SigTimeoutTick is the base class of all states checked by the idle timer.
+The timer interrupt calls tick() of every registered state.
+*/
+class SigTimeoutTick {
+private:
+    // next_tick is the next registered state (linked list).
+    SigTimeoutTick *next_tick = NULL;
+    // first_tick is the first registered state.
+    static SigTimeoutTick *first_tick;
+protected:
+    // tick checks the idle deadline; called from the timer interrupt.
+    virtual void tick() = 0;
+    // attach registers the state at the timer interrupt and enables the interrupt.
+    // It returns false if the timer is not supported or not enabled. Attaching again has no effect.
+    bool attach();
+public:
+    // tickAll calls tick() of all registered states; called from the timer interrupt.
+    static void tickAll();
+};
+
+/*
+SigTimeout adds a timer-driven idle timeout to a SigState. Once a signal is received,
+the idle deadline is checked by a hardware timer interrupt, which sets the state IDLE
+and calls an optional callback when the wait period has passed. The main loop can then
+sleep or do long work without the signal state going stale.
+
+The timer mode must be enabled by defining SIGSTATE_USE_TIMER before including SignalState.h.
+It is currently supported on AVR boards only, using the compare-B interrupt of Timer0, which
+fires every 1.024 ms alongside the millis() overflow interrupt. On other boards, or without
+SIGSTATE_USE_TIMER, begin() returns false and the state goes idle when calling next() as usual.
+
+Usage Example:
+
+    #define SIGSTATE_USE_TIMER
+    #include "SignalState.h"
+
+    SigTimeout<> State;
+
+    void onIdle(int signal) { stopMotor(); }  // runs in the ISR, keep it short!
+
+    void setup() {
+        State.setIdleCallback(onIdle);
+        State.begin();
+    }
+
+*/
+template <class StateT = SigState>
+class SigTimeout : public StateT, public SigTimeoutTick {
+public:
+    typedef typename StateT::signal_type SignalT;
+    typedef typename StateT::time_type TimeT;
+    // callback_t is the type of the idle callback, which receives the signal that went idle.
+    typedef void (*callback_t)(SignalT signal);
+private:
+    // armed is true while the idle deadline must be checked by the timer.
+    volatile bool armed = false;
+    // idle_callback is called after going idle (NULL=none), usually from the timer interrupt.
+    callback_t idle_callback = NULL;
+protected:
+    void tick();
+public:
+    inline SigTimeout() {}
+    ~SigTimeout() {}
+
+    // begin registers the state at the idle timer and returns false if the timer is not available.
+    bool begin() { return attach(); }
+
+    // next checks the current state and advances it if necessary.
+    int next() { return nextAt(StateT::now()); }
+    // next processes the next input signal and arms the idle deadline.
+    int next(SignalT input_signal) { return nextAt(input_signal, StateT::now()); }
+    // nextAt works like next, but uses the given time instead of reading the clock.
+    int nextAt(TimeT now);
+    // nextAt works like next, but uses the given receive time instead of reading the clock.
+    int nextAt(SignalT input_signal, TimeT now);
+
+    // drain processes the oldest queued signal using its recorded receive time,
+    // or checks the current state via next() if the queue is empty.
+    template <class Queue>
+    int drain(Queue &queue) {
+        typename Queue::signal_type input_signal;
+        typename Queue::time_type time;
+        if (queue.pop(input_signal, time)) return nextAt((SignalT)input_signal, (TimeT)time);
+        return next();
+    }
+
+    // signal returns the current active signal, read safely from the timer interrupt.
+    SignalT signal() { SignalT s; SIGTIMEOUT_ATOMIC { s = StateT::signal(); } return s; }
+    // state returns the current state, read safely from the timer interrupt.
+    int state() { int s; SIGTIMEOUT_ATOMIC { s = StateT::state(); } return s; }
+    // setIdle sets the state to idle and disarms the idle deadline.
+    void setIdle() { SIGTIMEOUT_ATOMIC { StateT::setIdle(); armed = false; } }
+
+    // setIdleCallback sets the function called after going idle. It is called from the
+    // timer interrupt, or from next() if next() noticed the timeout before the timer.
+    void setIdleCallback(callback_t callback) { idle_callback = callback; }
+};
+
+#endif // SigTimeout_h
+#pragma once
@@ -38,12 +38,26 @@
 #define VERSION_SIGNALSTATE_MINOR 0
 
 // #define DEBUG_SIGNALSTATE // Enable debug output from the SigState library.
+// #define SIGSTATE_USE_TIMER // Enable the timer interrupt of SigTimeout (uses Timer0 compare B on AVR).
 
+#include "SigQueue.h"
 #include "SigState.h"
+#include "SigStateBank.h"
+#include "SigEvents.h"
+#include "SigGestures.h"
+#include "SigAdaptive.h"
+#include "SigScanner.h"
+#include "SigTimeout.h"
 /*
  * Include the sources here to enable compilation with macro values set by user program.
  */
 #include "SigState.cpp.h"
+#include "SigStateBank.cpp.h"
+#include "SigEvents.cpp.h"
+#include "SigGestures.cpp.h"
+#include "SigAdaptive.cpp.h"
+#include "SigScanner.cpp.h"
+#include "SigTimeout.cpp.h"
 
 #endif // SignalState_h
 #pragma once